@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <optional>
@@ -35,6 +38,7 @@ SIF_NAMESPACE_BEGIN
 
 class List;
 class Dictionary;
+class HashSet;
 
 #define MAJOR_VERSION 0
 #define MINOR_VERSION 1
@@ -62,9 +66,89 @@ using Float = double;
 
 template <class T, class E> using Result = std::expected<T, E>;
 
-template <class T> using Strong = std::shared_ptr<T>;
+// Base for objects owned through Strong. The count is embedded in the object and updated without
+// atomics, so a counted object must only be shared within one thread.
+class Counted {
+  public:
+    Counted() = default;
+    Counted(const Counted &) {}
+    Counted &operator=(const Counted &) { return *this; }
 
-template <class T> using Weak = std::weak_ptr<T>;
+    void retain() const { _references++; }
+    bool release() const { return --_references == 0; }
+    uint32_t references() const { return _references; }
+
+  private:
+    mutable uint32_t _references = 0;
+};
+
+template <class T> class Strong {
+  public:
+    using element_type = T;
+
+    Strong() = default;
+    Strong(std::nullptr_t) {}
+    explicit Strong(T *pointer) : _pointer(pointer) { retain(); }
+    Strong(const Strong &strong) : _pointer(strong._pointer) { retain(); }
+    Strong(Strong &&strong) noexcept : _pointer(std::exchange(strong._pointer, nullptr)) {}
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    Strong(const Strong<U> &strong) : _pointer(strong.get()) {
+        retain();
+    }
+
+    template <class U, class = std::enable_if_t<std::is_convertible_v<U *, T *>>>
+    Strong(Strong<U> &&strong) noexcept : _pointer(std::exchange(strong._pointer, nullptr)) {}
+
+    ~Strong() { release(); }
+
+    Strong &operator=(const Strong &strong) {
+        strong.retain();
+        release();
+        _pointer = strong._pointer;
+        return *this;
+    }
+
+    Strong &operator=(Strong &&strong) noexcept {
+        if (this != &strong) {
+            release();
+            _pointer = std::exchange(strong._pointer, nullptr);
+        }
+        return *this;
+    }
+
+    void reset() {
+        release();
+        _pointer = nullptr;
+    }
+
+    T *get() const { return _pointer; }
+    T &operator*() const { return *_pointer; }
+    T *operator->() const { return _pointer; }
+    explicit operator bool() const { return _pointer != nullptr; }
+
+    template <class U> bool operator==(const Strong<U> &strong) const {
+        return _pointer == strong.get();
+    }
+    bool operator==(std::nullptr_t) const { return _pointer == nullptr; }
+
+  private:
+    template <class U> friend class Strong;
+
+    void retain() const {
+        if (_pointer) {
+            _pointer->retain();
+        }
+    }
+
+    void release() const {
+        if (_pointer && _pointer->release()) {
+            delete _pointer;
+        }
+    }
+
+    T *_pointer = nullptr;
+};
 
 template <class T> using Owned = std::unique_ptr<T>;
 
@@ -86,16 +170,17 @@ std::enable_if_t<!std::is_array<T>::value, std::unique_ptr<T>> MakeOwned(Args &&
     return std::unique_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
-template <class T, class... Args> std::shared_ptr<T> MakeStrong(Args &&...args) {
-    return std::shared_ptr<T>(new T(std::forward<Args>(args)...));
+template <class T, class... Args> Strong<T> MakeStrong(Args &&...args) {
+    return Strong<T>(new T(std::forward<Args>(args)...));
 }
 
 template <class T, class U> Strong<T> Cast(const Strong<U> &arg) {
-    return std::dynamic_pointer_cast<T>(arg);
+    return Strong<T>(dynamic_cast<T *>(arg.get()));
 }
 
 template <class T>
-inline constexpr bool IsTrackedContainer = std::is_same_v<T, List> || std::is_same_v<T, Dictionary>;
+inline constexpr bool IsTrackedContainer =
+    std::is_same_v<T, List> || std::is_same_v<T, Dictionary> || std::is_same_v<T, HashSet>;
 
 template <typename Iterable>
 using ValueType = typename std::iterator_traits<typename Iterable::iterator>::value_type;
@@ -139,3 +224,7 @@ template <class... Ts> struct Overload : Ts... { using Ts::operator()...; };
 template <class... Ts> Overload(Ts...) -> Overload<Ts...>;
 
 SIF_NAMESPACE_END
+
+template <class T> struct std::hash<sif::Strong<T>> {
+    size_t operator()(const sif::Strong<T> &strong) const { return std::hash<T *>()(strong.get()); }
+};
@@ -34,6 +34,7 @@ struct Variable;
 struct RangeLiteral;
 struct ListLiteral;
 struct DictionaryLiteral;
+struct SetLiteral;
 struct Literal;
 struct StringInterpolation;
 
@@ -47,6 +48,7 @@ struct Expression : Node {
         virtual void visit(const RangeLiteral &) = 0;
         virtual void visit(const ListLiteral &) = 0;
         virtual void visit(const DictionaryLiteral &) = 0;
+        virtual void visit(const SetLiteral &) = 0;
         virtual void visit(const Literal &) = 0;
         virtual void visit(const StringInterpolation &) = 0;
     };
@@ -175,6 +177,20 @@ struct DictionaryLiteral : Expression {
     void accept(Expression::Visitor &v) const override { v.visit(*this); }
 };
 
+struct SetLiteral : Expression {
+    std::vector<Strong<Expression>> expressions;
+
+    struct {
+        SourceRange leftBrace;
+        Optional<SourceRange> rightBrace;
+        std::vector<SourceRange> commas;
+    } ranges;
+
+    SetLiteral(std::vector<Strong<Expression>> expressions = {});
+
+    void accept(Expression::Visitor &v) const override { v.visit(*this); }
+};
+
 struct Variable : Expression {
     enum Scope { Local, Global };
 
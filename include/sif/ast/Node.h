@@ -20,7 +20,7 @@
 
 SIF_NAMESPACE_BEGIN
 
-struct Node {
+struct Node : Counted {
     SourceRange range;
 
     virtual ~Node() = default;
@@ -69,6 +69,7 @@ class PrettyPrinter : public Statement::Visitor,
     void visit(const RangeLiteral &) override;
     void visit(const ListLiteral &) override;
     void visit(const DictionaryLiteral &) override;
+    void visit(const SetLiteral &) override;
     void visit(const Literal &) override;
     void visit(const StringInterpolation &) override;
 
@@ -78,6 +78,7 @@ class SourceAnnotator : public Statement::Visitor,
     void visit(const RangeLiteral &) override;
     void visit(const ListLiteral &) override;
     void visit(const DictionaryLiteral &) override;
+    void visit(const SetLiteral &) override;
     void visit(const Literal &) override;
     void visit(const StringInterpolation &) override;
 
@@ -19,6 +19,8 @@
 #include <sif/Common.h>
 #include <sif/runtime/Value.h>
 
+#include <initializer_list>
+#include <unordered_map>
 #include <vector>
 
 SIF_NAMESPACE_BEGIN
@@ -36,6 +38,7 @@ enum class Opcode : uint8_t {
     List,
     UnpackList,
     Dictionary,
+    Set,
     Short,
     Negate,
     Not,
@@ -73,9 +76,47 @@ enum class Opcode : uint8_t {
     PushJump,
     PopJump,
     ToString,
+    OpenCountedRange,
+    ClosedCountedRange,
+    JumpIfCountAtEnd,
+    NextCount,
+
+    // Register instructions. Their operands name local slots or constants directly instead of
+    // passing values through the stack; see RegisterConstant and RegisterStack.
+    RegisterMove,
+    RegisterAdd,
+    RegisterSubtract,
+    RegisterMultiply,
+    RegisterDivide,
+    RegisterModulo,
+    RegisterEqual,
+    RegisterNotEqual,
+    RegisterLessThan,
+    RegisterGreaterThan,
+    RegisterLessThanOrEqual,
+    RegisterGreaterThanOrEqual,
+
+    // Superinstructions. Each replaces only the first opcode of the sequence it stands for and
+    // leaves the following instructions in place, so jumps into the middle of a sequence still
+    // land on valid code.
+    GetLocalGetLocal,
+    GetLocalShort,
+    JumpIfFalsePop,
+    CallSetIt,
+    ListReturn,
+    EnumerateUnpackList,
 };
 
-class Bytecode {
+// Returns the encoded size in bytes of an instruction, including its operands.
+size_t InstructionLength(Opcode opcode);
+
+// Register operands below RegisterConstant name a local slot of the current frame. Operands from
+// RegisterConstant up name the constant at (operand - RegisterConstant), except RegisterStack,
+// which pops a source operand from the stack or pushes a destination onto it.
+inline constexpr uint16_t RegisterConstant = 0x8000;
+inline constexpr uint16_t RegisterStack = 0xFFFF;
+
+class Bytecode : public Counted {
   public:
     using Iterator = std::vector<Opcode>::const_iterator;
 
@@ -83,6 +124,7 @@ class Bytecode {
 
     size_t add(SourceLocation location, Opcode opcode);
     size_t add(SourceLocation location, Opcode opcode, uint16_t argument);
+    size_t add(SourceLocation location, Opcode opcode, std::initializer_list<uint16_t> operands);
     void addRepeat(SourceLocation location, uint16_t argument);
     uint16_t addLocal(std::string local);
     uint16_t addConstant(const Value &constant);
@@ -92,6 +134,9 @@ class Bytecode {
     void patchRelativeJumpTo(size_t location, size_t target);
     void patchAbsoluteJump(size_t location);
 
+    // Rewrites common instruction pairs to superinstructions. Must run after all jumps are patched.
+    void fuseSuperinstructions();
+
     const std::string &name() const;
     const std::vector<Opcode> &code() const;
     const std::vector<std::string> &locals() const;
@@ -109,25 +154,46 @@ class Bytecode {
     friend class VirtualMachine;
     friend struct BytecodePrinter;
 
+    void addLocation(size_t position, SourceLocation location);
+
     std::string decodePosition(Iterator position) const;
 
     Iterator disassembleConstant(std::ostream &, const std::string &, Iterator) const;
     Iterator disassembleDictionary(std::ostream &out, Iterator position) const;
-    Iterator disassembleList(std::ostream &, Iterator) const;
+    Iterator disassembleList(std::ostream &, const std::string &name, Iterator) const;
     Iterator disassembleUnpackList(std::ostream &, Iterator) const;
     Iterator disassembleJump(std::ostream &, const std::string &name, Iterator) const;
     Iterator disassembleRepeat(std::ostream &, const std::string &name, Iterator) const;
     Iterator disassembleShort(std::ostream &out, Iterator position) const;
     Iterator disassembleCall(std::ostream &out, const std::string &name, Iterator position) const;
     Iterator disassembleLocal(std::ostream &out, const std::string &name, Iterator position) const;
+    Iterator disassembleRegisters(std::ostream &, const std::string &name, Iterator) const;
     Iterator disassemble(std::ostream &, Iterator) const;
 
     std::string _name;
     std::vector<Opcode> _code;
     std::vector<Value> _constants;
+    // Indices into _constants keyed by ConstantHash, so interning a constant doesn't scan them all.
+    std::unordered_multimap<size_t, uint16_t> _constantIndices;
     std::vector<std::string> _locals;
-    std::vector<SourceLocation> _locations;
-    Mapping<size_t, std::vector<SourceRange>> _argumentRanges;
+
+    // Source locations are delta encoded in _lineTable, with one entry for each instruction whose
+    // location differs from the previous one. Every LineCheckpointInterval entries the decoded
+    // state is kept as a checkpoint, so a lookup decodes only a short run of entries.
+    struct LineState {
+        uint32_t position = 0;
+        uint32_t index = 0;
+        SourceLocation location;
+    };
+    static constexpr size_t LineCheckpointInterval = 32;
+    std::vector<uint8_t> _lineTable;
+    std::vector<LineState> _lineCheckpoints;
+    LineState _lastLine;
+    size_t _lineEntries = 0;
+
+    // Argument ranges of each call, stored contiguously and indexed by call location.
+    std::vector<std::pair<size_t, size_t>> _argumentRangeIndex;
+    std::vector<SourceRange> _argumentRanges;
 };
 
 SIF_NAMESPACE_END
@@ -33,6 +33,10 @@ struct CompilerConfig {
     Reporter &errorReporter;
     bool interactive = false;
     bool enableDebugInfo = true;
+
+    // Lower arithmetic, comparisons and moves between locals and numeric literals to register
+    // instructions that address frame slots directly instead of going through the stack.
+    bool registerInstructions = false;
 };
 
 class Compiler : public Statement::Visitor,
@@ -81,6 +85,13 @@ class Compiler : public Statement::Visitor,
     void resolve(const Call &call, const std::string &name);
     void resolve(const Variable &variable, const std::string &name);
 
+    Optional<uint16_t> registerOperand(const Expression &expression);
+    std::pair<uint16_t, uint16_t> registerOperands(const Binary &binary);
+    bool assignRegister(const Assignment &assignment);
+
+    // Marks a string constant as a literal the VirtualMachine can push without copying.
+    void markLiteral(uint16_t index);
+
     void addImplicitReturnIfNeeded();
     void addLocal(const std::string &name = "");
 
@@ -114,6 +125,7 @@ class Compiler : public Statement::Visitor,
     void visit(const RangeLiteral &) override;
     void visit(const ListLiteral &) override;
     void visit(const DictionaryLiteral &) override;
+    void visit(const SetLiteral &) override;
     void visit(const Literal &) override;
     void visit(const StringInterpolation &) override;
 
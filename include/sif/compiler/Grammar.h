@@ -23,7 +23,7 @@
 
 SIF_NAMESPACE_BEGIN
 
-struct Grammar {
+struct Grammar : Counted {
     Strong<Grammar> argument;
     Mapping<std::string, Strong<Grammar>> terms;
 
@@ -21,8 +21,10 @@
 
 SIF_NAMESPACE_BEGIN
 
-class Module {
+class Module : public Counted {
   public:
+    virtual ~Module() = default;
+
     virtual std::vector<Signature> signatures() const = 0;
     virtual Mapping<std::string, Value> values() const = 0;
 };
@@ -170,6 +170,7 @@ class Parser {
     Strong<Expression> parseVariable();
     Strong<Expression> parseGrouping();
     Strong<Expression> parseContainerLiteral();
+    Strong<Expression> parseSetLiteral();
 
     ParserConfig _config;
 
@@ -21,7 +21,7 @@
 
 SIF_NAMESPACE_BEGIN
 
-class Reader {
+class Reader : public Counted {
   public:
     virtual ~Reader() = default;
 
@@ -25,7 +25,7 @@
 
 SIF_NAMESPACE_BEGIN
 
-class Scanner {
+class Scanner : public Counted {
   public:
     Scanner();
 
@@ -29,7 +29,7 @@
 SIF_NAMESPACE_BEGIN
 namespace lsp {
 
-struct Document {
+struct Document : Counted {
     std::string uri;
     std::string content;
     int version = 0;
@@ -0,0 +1,123 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+
+#include <array>
+
+SIF_NAMESPACE_BEGIN
+
+// Slab pools that every runtime object is allocated from. Slabs are carved into cells of a
+// fixed size class as they are needed, and freed cells are reused by the next object of that
+// class. Objects too large for any size class are allocated on their own.
+//
+// Each VirtualMachine owns a heap and makes it current while it runs, so the objects it creates
+// come from its own pools. This includes objects created by natives and enumerators. Objects
+// allocated while no machine is running use a heap that belongs to the thread.
+//
+// A heap outlives its owner while any of its objects are alive, and is freed with the last one.
+class Heap {
+  public:
+    struct Statistics {
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t liveObjects = 0;
+        size_t liveBytes = 0;
+        size_t slabs = 0;
+        size_t reservedBytes = 0;
+        size_t peakReservedBytes = 0;
+    };
+
+    // Makes a heap current until the scope ends.
+    class Scope {
+      public:
+        Scope(Heap &heap) : _previous(std::exchange(_current, &heap)) {}
+        ~Scope() { _current = _previous; }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+      private:
+        Heap *_previous;
+    };
+
+    Heap() = default;
+    Heap(const Heap &) = delete;
+    Heap &operator=(const Heap &) = delete;
+
+    // Gives up the owner's reference. The heap is freed now if it has no live objects, or
+    // otherwise when the last one is deallocated.
+    void abandon();
+
+    const Statistics &statistics() const { return _statistics; }
+
+    // Allocates from the current heap.
+    static void *Allocate(size_t size);
+
+    // Returns memory to the heap it was allocated from. The size must be the one it was allocated
+    // with.
+    static void Deallocate(void *pointer, size_t size);
+
+  private:
+    struct Slab;
+    struct Cell {
+        Cell *next;
+    };
+
+    static constexpr size_t SlabSize = 64 * 1024;
+    static constexpr size_t SlabHeaderSize = 64;
+    static constexpr size_t CellAlignment = 16;
+    static constexpr size_t MaximumCellSize = 512;
+    static constexpr size_t SizeClassCount = MaximumCellSize / CellAlignment;
+
+    // Precedes each object too large for a size class, which is told apart from cells by its size
+    // when it is freed.
+    struct alignas(CellAlignment) LargeObject {
+        Heap *heap;
+        size_t bytes;
+    };
+
+    ~Heap();
+
+    static Heap *ThreadHeap();
+
+    void *allocate(size_t size);
+    void *allocateLarge(size_t size);
+    void deallocate(Slab *slab, void *pointer);
+    void deallocateLarge(LargeObject *object);
+    void freeIfAbandoned();
+    Slab *makeSlab(size_t cellSize);
+    void reserve(size_t bytes);
+
+    inline static thread_local Heap *_current = nullptr;
+
+    // The heap belonging to the thread, which gives it up when the thread exits. Both are trivially
+    // destructible, so that thread-local destructors running after that can still read them.
+    inline static thread_local Heap *_threadHeap = nullptr;
+    inline static thread_local bool _threadExited = false;
+
+    // Free cells, then the uncarved remainder of the newest slab, of each size class.
+    std::array<Cell *, SizeClassCount> _freeLists{};
+    std::array<char *, SizeClassCount> _cursors{};
+    std::array<char *, SizeClassCount> _limits{};
+    Slab *_slabs = nullptr;
+    Statistics _statistics;
+    bool _abandoned = false;
+};
+
+SIF_NAMESPACE_END
@@ -25,6 +25,7 @@ SIF_NAMESPACE_BEGIN
 
 struct ModuleLoaderConfig {
     std::vector<std::filesystem::path> searchPaths;
+    bool registerInstructions = false;
 #if defined(DEBUG)
     bool enableTracing = false;
 #endif
@@ -18,14 +18,48 @@
 
 #include <sif/Common.h>
 
-#include <functional>
+#include <type_traits>
 
 SIF_NAMESPACE_BEGIN
 
-class Object {
+class Tracer;
+class VirtualMachine;
+
+class Object : public Counted {
   public:
+    // The runtime classes, tagged on each object so casts need no RTTI. Objects defined outside the
+    // runtime are Other.
+    enum class Kind : uint8_t {
+        Other,
+        String,
+        List,
+        Dictionary,
+        HashSet,
+        Range,
+        Function,
+        Native,
+        StringEnumerator,
+        ListEnumerator,
+        DictionaryEnumerator,
+        HashSetEnumerator,
+        RangeEnumerator,
+        // Elements that copies of a list or dictionary share until one of them changes.
+        SharedStorage,
+    };
+
+    Object(Kind kind = Kind::Other) : _kind(kind) {}
     virtual ~Object() = default;
 
+    // Objects are allocated from the current Heap, which is told their size again when they are
+    // freed.
+    static void *operator new(size_t size);
+    static void operator delete(void *pointer, size_t size);
+
+    Kind kind() const { return _kind; }
+
+    // Hides Counted::release, so that releasing a Strong reference finds possible cycle roots.
+    bool release() const;
+
     virtual std::string typeName() const = 0;
     virtual bool equals(Strong<Object>) const;
     virtual size_t hash() const;
@@ -35,10 +69,120 @@ class Object {
     virtual std::string description(Set<const Object *> &visited) const;
     virtual std::string debugDescription() const;
 
-    virtual void trace(const std::function<void(Strong<Object> &)> &visitor) {}
+    // Reports each reference this object holds to the tracer.
+    virtual void trace(Tracer &tracer) {}
     bool visited = false;
+
+    // Set on string constants, which are pushed without being copied. See VirtualMachine::own.
+    bool literal = false;
+
+  private:
+    Kind _kind;
 };
 
+// Runtime classes and protocols list the kinds that implement them in a static Kinds mask. The
+// mask is tagged with the type declaring it, because a subclass defined outside the runtime
+// inherits its base's mask even though most objects of those kinds are not instances of it.
+constexpr uint32_t KindBit(Object::Kind kind) { return 1u << static_cast<uint32_t>(kind); }
+
+template <class T> struct KindMask {
+    constexpr KindMask(uint32_t bits) : bits(bits) {}
+    constexpr operator uint32_t() const { return bits; }
+
+    uint32_t bits;
+};
+
+template <class T>
+concept DeclaresKinds = std::is_same_v<std::remove_cv_t<decltype(T::Kinds)>, KindMask<T>>;
+
+// A runtime object that can be part of a garbage cycle: a container, the elements its copies
+// share, or an enumerator holding one. Only these are tracked or examined by the collector, so
+// leaves carry none of its state.
+class TrackedObject : public Object {
+  public:
+    static constexpr KindMask<TrackedObject> Kinds =
+        KindBit(Kind::List) | KindBit(Kind::Dictionary) | KindBit(Kind::HashSet) |
+        KindBit(Kind::ListEnumerator) | KindBit(Kind::DictionaryEnumerator) |
+        KindBit(Kind::HashSetEnumerator) | KindBit(Kind::SharedStorage);
+
+    TrackedObject(Kind kind) : Object(kind) {}
+    ~TrackedObject() override;
+
+    // Set by a collection that finds this container refers only to leaves, so that dropping a
+    // reference to it cannot leave a cycle. Containers clear it whenever they change.
+    bool acyclic = false;
+
+    // The VirtualMachine tracking this object for cycle collection, which is told when the object
+    // is destroyed.
+    VirtualMachine *tracker = nullptr;
+
+  private:
+    friend class Object;
+    friend class Tracer;
+    friend class VirtualMachine;
+
+    void bufferCycleCandidate() const;
+
+    // The neighbors of this object in its tracker's list of containers, and the size the tracker
+    // last accounted for, so that tracking needs no lookups or allocations.
+    TrackedObject *_previousTracked = nullptr;
+    TrackedObject *_nextTracked = nullptr;
+    size_t _trackedBytes = 0;
+
+    // Whether this object is in its tracker's young generation, and its references from outside
+    // the objects a young collection examines.
+    bool _young = false;
+    uint32_t _externalReferences = 0;
+};
+
+// Only an object whose count drops to a nonzero value can be left in a garbage cycle: a tracked
+// container that is not known to be acyclic, or an enumerator holding one.
+inline bool Object::release() const {
+    if (Counted::release()) {
+        return true;
+    }
+    if (KindBit(_kind) & TrackedObject::Kinds) {
+        constexpr auto enumeratorKinds = KindBit(Kind::ListEnumerator) |
+                                         KindBit(Kind::DictionaryEnumerator) |
+                                         KindBit(Kind::HashSetEnumerator);
+        auto object = static_cast<const TrackedObject *>(this);
+        if ((object->tracker && !object->_young && !object->acyclic) ||
+            (KindBit(_kind) & enumeratorKinds)) {
+            object->bufferCycleCandidate();
+        }
+    }
+    return false;
+}
+
+// Casts an object to a protocol it implements according to its kind.
+template <class T> T *ProtocolCast(Object *object);
+
+// Casts an object to a runtime class or protocol by comparing its kind with T::Kinds. Objects of
+// other kinds, and types that do not declare their own Kinds mask, fall back to dynamic_cast.
+template <class T> T *ObjectCast(Object *object) {
+    if constexpr (std::is_same_v<T, Object>) {
+        return object;
+    } else if constexpr (!DeclaresKinds<T>) {
+        return dynamic_cast<T *>(object);
+    } else {
+        if (!object) {
+            return nullptr;
+        }
+        auto kind = object->kind();
+        if (kind == Object::Kind::Other) {
+            return dynamic_cast<T *>(object);
+        }
+        if (!(KindBit(kind) & T::Kinds)) {
+            return nullptr;
+        }
+        if constexpr (std::is_base_of_v<Object, T>) {
+            return static_cast<T *>(object);
+        } else {
+            return ProtocolCast<T>(object);
+        }
+    }
+}
+
 std::ostream &operator<<(std::ostream &out, const Strong<Object> &object);
 
 SIF_NAMESPACE_END
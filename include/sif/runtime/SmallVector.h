@@ -0,0 +1,332 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+SIF_NAMESPACE_BEGIN
+
+// A vector that keeps up to N elements inline, and only allocates a buffer once it grows past
+// them. It supports the subset of the std::vector interface that the runtime uses.
+//
+// Erasing the first elements leaves room in front of the rest, and inserting at the front reuses
+// that room or makes more, so that the vector also works as a queue or a deque: pushing and
+// popping at either end takes amortized constant time.
+template <typename T, size_t N> class SmallVector {
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    SmallVector() = default;
+
+    template <typename Iterator> SmallVector(Iterator first, Iterator last) { append(first, last); }
+
+    SmallVector(const SmallVector &other) { append(other.begin(), other.end()); }
+
+    SmallVector(SmallVector &&other) noexcept { take(std::move(other)); }
+
+    ~SmallVector() {
+        clear();
+        release();
+    }
+
+    SmallVector &operator=(const SmallVector &other) {
+        if (this != &other) {
+            assign(other.begin(), other.end());
+        }
+        return *this;
+    }
+
+    SmallVector &operator=(SmallVector &&other) noexcept {
+        if (this != &other) {
+            clear();
+            release();
+            take(std::move(other));
+        }
+        return *this;
+    }
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    // The number of elements the storage holds, including the room in front of the elements.
+    size_t capacity() const { return _capacity; }
+
+    // Whether the elements are stored in the vector itself rather than in a separate buffer.
+    bool isInline() const { return storage() == inlineData(); }
+
+    T *data() { return _data; }
+    const T *data() const { return _data; }
+
+    iterator begin() { return _data; }
+    iterator end() { return _data + _size; }
+    const_iterator begin() const { return _data; }
+    const_iterator end() const { return _data + _size; }
+    reverse_iterator rbegin() { return reverse_iterator(end()); }
+    reverse_iterator rend() { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+    T &operator[](size_t index) { return _data[index]; }
+    const T &operator[](size_t index) const { return _data[index]; }
+    T &front() { return _data[0]; }
+    const T &front() const { return _data[0]; }
+    T &back() { return _data[_size - 1]; }
+    const T &back() const { return _data[_size - 1]; }
+
+    void reserve(size_t capacity) {
+        if (capacity > _capacity - _front) {
+            if (capacity <= _capacity) {
+                reclaimFront();
+            } else {
+                relocate(capacity, 0);
+            }
+        }
+    }
+
+    void clear() {
+        std::destroy(begin(), end());
+        _size = 0;
+        _data = storage();
+        _front = 0;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    template <typename... Args> T &emplace_back(Args &&...args) {
+        if (_front + _size == _capacity) {
+            // The argument may refer to an element, so construct it before the elements move.
+            T value(std::forward<Args>(args)...);
+            grow(_size + 1);
+            return *new (_data + _size++) T(std::move(value));
+        }
+        return *new (_data + _size++) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() { std::destroy_at(_data + --_size); }
+
+    template <typename Iterator> void assign(Iterator first, Iterator last) {
+        clear();
+        append(first, last);
+    }
+
+    iterator insert(const_iterator position, const T &value) {
+        auto index = position - begin();
+        if (index == 0 && _size + 1 > N) {
+            T copy(value);
+            makeRoomAtFront(1);
+            return prepend(&copy, &copy + 1);
+        }
+        push_back(value);
+        std::rotate(begin() + index, end() - 1, end());
+        return begin() + index;
+    }
+
+    iterator insert(const_iterator position, size_t count, const T &value) {
+        auto index = position - begin();
+        auto size = _size;
+        T copy(value);
+        if (index == 0 && _size + count > N) {
+            makeRoomAtFront(count);
+            std::uninitialized_fill_n(_data - count, count, copy);
+            _data -= count;
+            _front -= count;
+            _size += count;
+            return begin();
+        }
+        grow(_size + count);
+        std::uninitialized_fill_n(end(), count, copy);
+        _size += count;
+        std::rotate(begin() + index, begin() + size, end());
+        return begin() + index;
+    }
+
+    template <typename Iterator>
+    iterator insert(const_iterator position, Iterator first, Iterator last) {
+        auto index = position - begin();
+        auto size = _size;
+        if constexpr (std::is_same_v<std::remove_cv_t<std::remove_pointer_t<Iterator>>, T>) {
+            // Inserting a vector into itself; copy the range before it moves.
+            if (first >= begin() && first < end()) {
+                SmallVector copy(first, last);
+                return insert(position, copy.begin(), copy.end());
+            }
+        }
+        using Category = typename std::iterator_traits<Iterator>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            auto count = static_cast<size_t>(std::distance(first, last));
+            if (index == 0 && _size + count > N) {
+                makeRoomAtFront(count);
+                return prepend(first, last);
+            }
+        }
+        append(first, last);
+        std::rotate(begin() + index, begin() + size, end());
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        auto index = first - begin();
+        auto count = last - first;
+        if (index == 0 && count > 0) {
+            // Leave the room in front of the remaining elements rather than moving them.
+            std::destroy(begin(), begin() + count);
+            _data += count;
+            _front += count;
+            _size -= count;
+            if (_size == 0) {
+                _data = storage();
+                _front = 0;
+            }
+        } else if (count > 0) {
+            auto newEnd = std::move(begin() + index + count, end(), begin() + index);
+            std::destroy(newEnd, end());
+            _size -= count;
+        }
+        return begin() + index;
+    }
+
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+
+    bool operator==(const SmallVector &other) const {
+        return std::equal(begin(), end(), other.begin(), other.end());
+    }
+
+  private:
+    T *inlineData() { return reinterpret_cast<T *>(_inline); }
+    const T *inlineData() const { return reinterpret_cast<const T *>(_inline); }
+
+    // The start of the storage, before any room in front of the elements.
+    T *storage() const { return _data - _front; }
+
+    // Makes room for count elements, counted from the first one.
+    void grow(size_t count) {
+        if (_front + count <= _capacity) {
+            return;
+        }
+        // The room in front of the elements was left by erasing them, so reclaim it rather than
+        // growing: always when the elements are inline, and when at least half of a buffer is
+        // free, so that a vector used as a queue moves each element a bounded number of times.
+        if (count <= _capacity && (isInline() || count * 2 <= _capacity)) {
+            reclaimFront();
+        } else {
+            relocate(std::max(count, _capacity * 2), 0);
+        }
+    }
+
+    // Makes room for count elements in front of the first one, leaving as much room in front of
+    // the elements as behind them.
+    void makeRoomAtFront(size_t count) {
+        if (count <= _front) {
+            return;
+        }
+        auto capacity = std::max((_size + count) * 2, _capacity);
+        relocate(capacity, (capacity - _size) / 2);
+    }
+
+    // Constructs the range in the room in front of the first element. Short vectors insert at the
+    // front by rotating instead, so that they can stay inline.
+    template <typename Iterator> iterator prepend(Iterator first, Iterator last) {
+        auto count = static_cast<size_t>(std::distance(first, last));
+        std::uninitialized_copy(first, last, _data - count);
+        _data -= count;
+        _front -= count;
+        _size += count;
+        return begin();
+    }
+
+    // Moves the elements down to the start of the storage, in place.
+    void reclaimFront() {
+        auto data = storage();
+        for (size_t i = 0; i < _size; i++) {
+            new (data + i) T(std::move(_data[i]));
+            std::destroy_at(_data + i);
+        }
+        _data = data;
+        _front = 0;
+    }
+
+    // Moves the elements into a new buffer, leaving room for front elements in front of them.
+    void relocate(size_t capacity, size_t front) {
+        auto data = static_cast<T *>(::operator new(capacity * sizeof(T))) + front;
+        std::uninitialized_move(begin(), end(), data);
+        std::destroy(begin(), end());
+        release();
+        _data = data;
+        _front = front;
+        _capacity = capacity;
+    }
+
+    template <typename Iterator> void append(Iterator first, Iterator last) {
+        using Category = typename std::iterator_traits<Iterator>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            grow(_size + std::distance(first, last));
+        }
+        for (; first != last; ++first) {
+            emplace_back(*first);
+        }
+    }
+
+    void release() {
+        if (!isInline()) {
+            ::operator delete(storage());
+            _data = inlineData();
+            _front = 0;
+            _capacity = N;
+        }
+    }
+
+    // Takes the elements of another vector, whose storage must be released already.
+    void take(SmallVector &&other) {
+        if (other.isInline()) {
+            std::uninitialized_move(other.begin(), other.end(), inlineData());
+            _size = other._size;
+            other.clear();
+        } else {
+            _data = std::exchange(other._data, other.inlineData());
+            _front = std::exchange(other._front, 0);
+            _size = std::exchange(other._size, 0);
+            _capacity = std::exchange(other._capacity, N);
+        }
+    }
+
+    T *_data = inlineData();
+    // The number of unused elements in front of _data.
+    size_t _front = 0;
+    size_t _size = 0;
+    size_t _capacity = N;
+    alignas(T) unsigned char _inline[N * sizeof(T)];
+};
+
+SIF_NAMESPACE_END
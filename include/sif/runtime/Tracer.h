@@ -0,0 +1,134 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+#include <sif/runtime/Object.h>
+
+#include <vector>
+
+SIF_NAMESPACE_BEGIN
+
+class VirtualMachine;
+
+// Receives the references an object holds when the collector traces it, and acts on each one
+// according to the phase of the collection. Visits are direct calls, and the worklist keeps its
+// storage from one collection to the next, so tracing allocates nothing once it has grown.
+class Tracer {
+  public:
+    enum class Phase : uint8_t {
+        // Marks objects reachable from the roots, queueing each one to be traced.
+        Mark,
+        // Drops every reference, breaking a garbage cycle.
+        Release,
+        // Subtracts references between examined objects, and examines the objects they reach.
+        Subtract,
+        // Marks examined objects reachable from an outside reference, queueing each one.
+        Restore,
+    };
+
+    // Kinds that hold no references, and so can never be part of a cycle. They are neither marked
+    // nor examined.
+    static constexpr uint32_t LeafKinds =
+        KindBit(Object::Kind::String) | KindBit(Object::Kind::Range) |
+        KindBit(Object::Kind::Native) | KindBit(Object::Kind::StringEnumerator) |
+        KindBit(Object::Kind::RangeEnumerator);
+
+    Tracer(VirtualMachine &machine) : _machine(machine) {}
+
+    void visit(Strong<Object> &reference) {
+        auto *object = reference.get();
+        if (!object) {
+            return;
+        }
+        if (phase == Phase::Release) {
+            reference.reset();
+            return;
+        }
+        if (KindBit(object->kind()) & LeafKinds) {
+            return;
+        }
+        references++;
+        switch (phase) {
+        case Phase::Mark:
+            if (!object->visited) {
+                object->visited = true;
+                worklist.push_back(object);
+            }
+            break;
+        case Phase::Subtract:
+            subtract(object);
+            break;
+        case Phase::Restore:
+            // Only TrackedObjects are examined.
+            if (object->visited) {
+                auto tracked = static_cast<TrackedObject *>(object);
+                if (tracked->_externalReferences == 0) {
+                    tracked->_externalReferences = 1;
+                    worklist.push_back(tracked);
+                }
+            }
+            break;
+        case Phase::Release:
+            break;
+        }
+    }
+
+    // Examines an object during the Subtract phase, counting its references as outside ones until
+    // they are subtracted.
+    void examine(TrackedObject *object) {
+        object->visited = true;
+        object->_externalReferences = object->references();
+        worklist.push_back(object);
+        examinedCount++;
+    }
+
+    Phase phase = Phase::Mark;
+    std::vector<Object *> worklist;
+
+    // The objects examined by the Subtract phase, and the most it may examine. Objects past the
+    // budget, containers tracked by other machines, acyclic containers and objects that are not
+    // TrackedObjects, such as functions, are treated as roots.
+    size_t examinedCount = 0;
+    size_t budget = 0;
+
+    // The references visited to objects that are not leaves, which the collector counts for each
+    // object it traces to find the acyclic ones.
+    size_t references = 0;
+
+  private:
+    void subtract(Object *reference) {
+        if (!(KindBit(reference->kind()) & TrackedObject::Kinds)) {
+            return;
+        }
+        auto object = static_cast<TrackedObject *>(reference);
+        if (!object->visited) {
+            if (budget > 0 && examinedCount >= budget) {
+                return;
+            }
+            if ((object->tracker && object->tracker != &_machine) || object->acyclic) {
+                return;
+            }
+            examine(object);
+        }
+        object->_externalReferences--;
+    }
+
+    VirtualMachine &_machine;
+};
+
+SIF_NAMESPACE_END
@@ -17,66 +17,138 @@
 #pragma once
 
 #include <sif/Common.h>
+#include <sif/runtime/Object.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <type_traits>
 #include <variant>
 
 SIF_NAMESPACE_BEGIN
 
-class Object;
-
 class Value {
   public:
-    enum class Type : size_t { Empty, Bool, Integer, Float, Object };
-
-    Value() = default;
-
-    Value(const Value &v) = default;
-    Value(Value &&v) = default;
-
-    template <typename T> Value(const T &v) : _value(v) {}
+    enum class Type : uint8_t { Empty, Bool, Integer, Float, Object };
+
+    Value() : _type(Type::Empty), _words{} {}
+
+    Value(const Value &v) : _type(v._type), _words{} { copyFrom(v); }
+    Value(Value &&v) noexcept : _type(v._type), _words{} { moveFrom(std::move(v)); }
+
+    template <typename T> Value(const T &v) : _words{} {
+        if constexpr (std::is_same_v<T, Bool>) {
+            _type = Type::Bool;
+            _bool = v;
+        } else if constexpr (std::is_integral_v<T>) {
+            _type = Type::Integer;
+            _integer = v;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            _type = Type::Float;
+            _float = v;
+        } else if constexpr (std::is_same_v<T, std::monostate>) {
+            _type = Type::Empty;
+        } else {
+            static_assert(std::is_convertible_v<T, Strong<Object>>, "unsupported value type");
+            _type = Type::Object;
+            new (&_object) Strong<Object>(v);
+        }
+    }
 
     Value(const std::string &string);
     Value(std::string_view view) : Value(std::string(view)) {}
 
+    ~Value() { release(); }
+
     Value &operator=(const Value &v) {
-        _value = v._value;
+        if (this != &v) {
+            release();
+            _type = v._type;
+            copyFrom(v);
+        }
         return *this;
     }
 
-    Value &operator=(Value &&v) {
-        _value = std::move(v._value);
+    Value &operator=(Value &&v) noexcept {
+        if (this != &v) {
+            release();
+            _type = v._type;
+            moveFrom(std::move(v));
+        }
         return *this;
     }
 
-    Type type() const;
+    Type type() const { return _type; }
     std::string typeName() const;
 
-    bool isEmpty() const;
-    bool isBool() const;
-    bool isInteger() const;
-    bool isNumber() const;
-    bool isFloat() const;
-    bool isObject() const;
+    bool isEmpty() const { return _type == Type::Empty; }
+    bool isBool() const { return _type == Type::Bool; }
+    bool isInteger() const { return _type == Type::Integer; }
+    bool isNumber() const { return _type == Type::Integer || _type == Type::Float; }
+    bool isFloat() const { return _type == Type::Float; }
+    bool isObject() const { return _type == Type::Object; }
     bool isString() const;
+    bool isLiteral() const { return _type == Type::Object && _object && _object->literal; }
+
+    Bool asBool() const {
+        if (_type != Type::Bool) {
+            TypeError("expected bool type");
+        }
+        return _bool;
+    }
+
+    Integer asInteger() const {
+        if (_type != Type::Integer) {
+            TypeError("expected integer type");
+        }
+        return _integer;
+    }
+
+    Float asFloat() const {
+        if (_type != Type::Float) {
+            TypeError("expected float type");
+        }
+        return _float;
+    }
 
-    Bool asBool() const;
-    Integer asInteger() const;
-    Float asFloat() const;
     Strong<Object> asObject() const;
 
     Strong<Object> &reference();
 
-    Integer castInteger() const;
-    Float castFloat() const;
+    Integer castInteger() const {
+        if (_type == Type::Integer) {
+            return _integer;
+        } else if (_type == Type::Float) {
+            return static_cast<Integer>(_float);
+        }
+        TypeError("can't convert value to number");
+    }
+
+    Float castFloat() const {
+        if (_type == Type::Float) {
+            return _float;
+        } else if (_type == Type::Integer) {
+            return static_cast<Float>(_integer);
+        }
+        TypeError("can't convert value to number");
+    }
 
-    template <typename T> Strong<T> as() const {
-        return isObject() ? Cast<T>(asObject()) : nullptr;
+    // Protocols are not counted themselves, so casting to one borrows the object instead.
+    template <typename T>
+    std::conditional_t<std::is_base_of_v<Counted, T>, Strong<T>, T *> as() const {
+        if (!isObject()) {
+            return nullptr;
+        }
+        if constexpr (std::is_base_of_v<Counted, T>) {
+            return Strong<T>(ObjectCast<T>(_object.get()));
+        } else {
+            return ObjectCast<T>(_object.get());
+        }
     }
 
     std::string toString() const;
@@ -90,12 +162,46 @@ class Value {
     };
 
   private:
-    std::variant<std::monostate, Bool, Integer, Float, Strong<Object>> _value;
+    [[noreturn]] static void TypeError(const char *message);
+
+    void copyFrom(const Value &v) {
+        if (_type == Type::Object) {
+            new (&_object) Strong<Object>(v._object);
+        } else {
+            std::copy(std::begin(v._words), std::end(v._words), std::begin(_words));
+        }
+    }
+
+    // Leaves the moved-from value empty rather than holding a null object.
+    void moveFrom(Value &&v) {
+        if (_type == Type::Object) {
+            new (&_object) Strong<Object>(std::move(v._object));
+            std::destroy_at(&v._object);
+            v._type = Type::Empty;
+            std::fill(std::begin(v._words), std::end(v._words), 0);
+        } else {
+            copyFrom(v);
+        }
+    }
+
+    void release() {
+        if (_type == Type::Object) {
+            std::destroy_at(&_object);
+        }
+    }
+
+    Type _type;
+    // Scalars are copied through _words so the whole payload is always initialized.
+    union {
+        uint64_t _words[1];
+        Bool _bool;
+        Integer _integer;
+        Float _float;
+        Strong<Object> _object;
+    };
 };
 
 std::ostream &operator<<(std::ostream &out, const Value &value);
 std::ostream &operator<<(std::ostream &out, const std::vector<Value> &values);
 
-using ValueMap = std::unordered_map<Value, Value, Value::Hash>;
-
 SIF_NAMESPACE_END
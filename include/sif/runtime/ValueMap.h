@@ -0,0 +1,144 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+#include <sif/runtime/Value.h>
+
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+SIF_NAMESPACE_BEGIN
+
+// A hash map from values to values that iterates in insertion order. Entries are stored densely in
+// the order they were inserted, and found through an open-addressed index of entry positions.
+//
+// Erasing an entry leaves a hole in the entries that iteration skips. Holes are compacted away the
+// next time the index grows.
+class ValueMap {
+  public:
+    struct Entry {
+        Value first;
+        Value second;
+        size_t hash;
+    };
+
+    template <typename T> class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T *;
+        using reference = T &;
+
+        Iterator() = default;
+        Iterator(T *entry, T *end) : _entry(entry), _end(end) { skipErased(); }
+        explicit Iterator(T *end) : _entry(end), _end(end) {}
+
+        reference operator*() const { return *_entry; }
+        pointer operator->() const { return _entry; }
+
+        Iterator &operator++() {
+            _entry++;
+            skipErased();
+            return *this;
+        }
+        Iterator operator++(int) {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+
+        bool operator==(const Iterator &other) const { return _entry == other._entry; }
+
+      private:
+        friend class ValueMap;
+
+        void skipErased() {
+            while (_entry != _end && _entry->hash == Erased) {
+                _entry++;
+            }
+        }
+
+        T *_entry = nullptr;
+        T *_end = nullptr;
+    };
+
+    using iterator = Iterator<Entry>;
+    using const_iterator = Iterator<const Entry>;
+
+    ValueMap() = default;
+    ValueMap(const ValueMap &) = default;
+    ValueMap(ValueMap &&other) noexcept;
+    ValueMap &operator=(const ValueMap &) = default;
+    ValueMap &operator=(ValueMap &&other) noexcept;
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void reserve(size_t count);
+    void clear();
+
+    iterator begin() { return iterator(_entries.data(), _entries.data() + _entries.size()); }
+    iterator end() { return iterator(_entries.data() + _entries.size()); }
+    const_iterator begin() const {
+        return const_iterator(_entries.data(), _entries.data() + _entries.size());
+    }
+    const_iterator end() const { return const_iterator(_entries.data() + _entries.size()); }
+
+    iterator find(const Value &key);
+    const_iterator find(const Value &key) const;
+    bool contains(const Value &key) const { return find(key) != end(); }
+
+    Value &operator[](const Value &key);
+    std::pair<iterator, bool> emplace(const Value &key, const Value &value);
+    size_t erase(const Value &key);
+
+    // Entries are numbered in insertion order, counting erased entries, until the map next grows.
+    // Enumerators hold on to a position rather than an iterator, so inserting while enumerating
+    // can't leave them dangling.
+    const_iterator seek(size_t position) const;
+    size_t position(const_iterator it) const { return it._entry - _entries.data(); }
+
+    // Bytes reserved for entries and the index, including unused capacity.
+    size_t reservedBytes() const;
+
+    bool operator==(const ValueMap &other) const;
+
+  private:
+    static constexpr size_t Erased = SIZE_MAX;
+    static constexpr uint32_t Unused = UINT32_MAX;
+
+    static size_t HashOf(const Value &key);
+
+    // Returns the slot in the index that holds the key's entry, or the unused slot that ends its
+    // probe sequence.
+    size_t probe(const Value &key, size_t hash) const;
+    // Returns the position of the key's entry, adding an entry with an empty value if there is
+    // none, and whether it was added.
+    std::pair<size_t, bool> locate(const Value &key);
+    // Compacts the entries and rebuilds the index with room for at least count entries.
+    void grow(size_t count);
+
+    std::vector<Entry> _entries;
+    std::vector<uint32_t> _index;
+    size_t _size = 0;
+};
+
+SIF_NAMESPACE_END
@@ -19,9 +19,13 @@
 #include <sif/Common.h>
 #include <sif/Error.h>
 #include <sif/compiler/Bytecode.h>
+#include <sif/runtime/Heap.h>
+#include <sif/runtime/Tracer.h>
 #include <sif/runtime/Value.h>
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <stack>
 #include <type_traits>
 #include <vector>
@@ -40,8 +44,45 @@ struct VirtualMachineConfig {
     size_t initialGarbageCollectionThresholdBytes = 64 * 1024;
     // Lower bound for the GC trigger threshold so it never shrinks too aggressively.
     size_t minimumGarbageCollectionThresholdBytes = 16 * 1024;
-    // Multiplier applied to the next threshold after each successful collection.
+    // Multiplier applied to the live bytes after a full collection to find the next full threshold.
     double garbageCollectionGrowthFactor = 1.5;
+    // Most objects one young collection examines. Each is traced once, so this bounds the pause
+    // together with the sizes of the containers examined. Objects that hold no references are
+    // never examined. The rest of the nursery is examined at the following safepoints. Zero
+    // examines the whole nursery at once.
+    size_t youngGarbageCollectionBudget = 4096;
+    // When false, the whole heap is only marked on request or when the machine is destroyed.
+    bool automaticFullGarbageCollection = true;
+};
+
+struct GarbageCollectionStatistics {
+    // A single collection. Objects marked are those proven reachable, and objects freed include
+    // untracked objects released with the garbage containers.
+    struct Collection {
+        bool full = false;
+        std::chrono::nanoseconds pause{0};
+        size_t objectsMarked = 0;
+        size_t objectsFreed = 0;
+        size_t bytesReclaimed = 0;
+    };
+
+    // Pauses are counted in buckets by powers of two microseconds: the first bucket counts pauses
+    // under 1us, the next under 2us, and the last every longer pause.
+    static constexpr size_t PauseBuckets = 24;
+
+    size_t youngCollections = 0;
+    size_t fullCollections = 0;
+    std::chrono::nanoseconds totalPause{0};
+    std::chrono::nanoseconds maximumPause{0};
+    size_t objectsMarked = 0;
+    size_t objectsFreed = 0;
+    size_t bytesReclaimed = 0;
+    size_t peakTrackedBytes = 0;
+    std::array<size_t, PauseBuckets> pauseHistogram{};
+    Collection lastCollection;
+
+    size_t collections() const { return youngCollections + fullCollections; }
+    void record(const Collection &collection);
 };
 
 struct CallFrame {
@@ -53,6 +94,8 @@ struct CallFrame {
     std::vector<size_t> sps;
     Value error;
     Value it;
+    // The global slots the executing machine resolved for the bytecode. See VirtualMachine::link.
+    uint32_t *globalSlots = nullptr;
 
     CallFrame(Strong<Bytecode> bytecode, const std::vector<size_t> &captures, size_t sp)
         : bytecode(bytecode), ip(bytecode->code().begin()), captures(captures), sp(sp) {}
@@ -69,8 +112,8 @@ class VirtualMachine {
     void addGlobal(const std::string &name, const Value &value);
     void addGlobals(const Mapping<std::string, Value> &globals);
 
-    const Mapping<std::string, Value> &globals() const;
-    const Mapping<std::string, Value> &exports() const;
+    Mapping<std::string, Value> globals() const;
+    Mapping<std::string, Value> exports() const;
 
     const Value &error() const { return _frames.back().error; }
     Value &error() { return _frames.back().error; }
@@ -78,29 +121,38 @@ class VirtualMachine {
     const Value &it() const { return _it; }
     Value &it() { return _it; }
 
+    // Returns a value that can be stored in a variable or container. String literals are pushed
+    // without being copied, so a literal is copied here before anything can mutate it.
+    Value own(Value value);
+
     void notifyContainerMutation(List *list);
     void notifyContainerMutation(Dictionary *dictionary);
+    void notifyContainerMutation(HashSet *set);
 
     void serviceGarbageCollection();
 
     size_t bytesSinceLastCollection() const { return _bytesSinceLastGc; }
     size_t currentTrackedBytes() const { return _liveContainerBytes; }
     size_t garbageCollectionCount() const { return _garbageCollectionCount; }
+    size_t youngContainerCount() const { return _youngContainerCount; }
+    size_t liveContainerCount() const { return _trackedContainerCount; }
+
+    const GarbageCollectionStatistics &garbageCollectionStatistics() const { return _gcStatistics; }
+
+    const Heap::Statistics &heapStatistics() const { return _heap->statistics(); }
 
-    template <class T, class... Args> std::shared_ptr<T> make(Args &&...args) {
+    template <class T, class... Args> Strong<T> make(Args &&...args) {
+        Heap::Scope scope(*_heap);
+        auto object = MakeStrong<T>(std::forward<Args>(args)...);
         if constexpr (IsTrackedContainer<T>) {
-            auto obj = std::shared_ptr<T>(new T(std::forward<Args>(args)...), [this](T *p) {
-                deregisterContainer(p);
-                delete p;
-            });
-            if (_inNativeCall) {
-                _transientRoots.emplace_back(obj);
+            // Tracking may collect, and the new container is not reachable from any root yet.
+            _transientRoots.push_back(object);
+            trackContainer(object.get());
+            if (!_inNativeCall) {
+                _transientRoots.pop_back();
             }
-            trackContainer(obj);
-            return obj;
-        } else {
-            return std::shared_ptr<T>(new T(std::forward<Args>(args)...));
         }
+        return object;
     }
 
     void collectGarbage();
@@ -115,44 +167,86 @@ class VirtualMachine {
 #endif
 
   private:
-    Optional<Error> call(Value, int, std::vector<SourceRange>);
+    friend class TrackedObject;
+
+    // A global variable or native, addressed by index from linked bytecode. Exports assigned by
+    // SetGlobal shadow globals added by the host.
+    struct GlobalSlot {
+        Value global;
+        Value exported;
+        bool hasGlobal = false;
+        bool hasExport = false;
+    };
+
+    static constexpr uint32_t UnresolvedSlot = UINT32_MAX;
+
+    // The global slots resolved for a bytecode, indexed by the constant holding each global's name.
+    // Entries are filled lazily the first time they execute. The bytecode is retained so that its
+    // address, which keys the link, is not reused by other bytecode.
+    struct Link {
+        Strong<Bytecode> bytecode;
+        std::vector<uint32_t> globalSlots;
+    };
+
+    uint32_t globalSlot(const std::string &name);
+    uint32_t resolveGlobal(const Bytecode &bytecode, uint32_t *globalSlots, uint16_t index);
+    uint32_t *link(const Strong<Bytecode> &bytecode);
+
+    Optional<Error> call(const Value &, int, size_t);
     Optional<Error> range(Value, Value, bool);
 
     CallFrame &frame();
 
-    void trackContainer(const Strong<Object> &container);
-    std::vector<Strong<Object>> gatherRootObjects() const;
+    void trackContainer(TrackedObject *object);
+    void traceRoots(Tracer &tracer);
 
     void refreshContainerMetrics(bool accumulateDebt);
     void maybeTriggerGarbageCollection();
     void runPendingGarbageCollection();
-    void cleanupExpiredContainers();
-    void deregisterContainer(Object *object);
-    void accountForContainer(Object *object, size_t newSize, bool accumulateDebt);
-    size_t estimateContainerSize(const Object *object) const;
+    size_t collectYoungContainers();
+    size_t collectAllContainers();
+    void linkContainer(TrackedObject *object, bool young);
+    void unlinkContainer(TrackedObject *object);
+    void rememberContainer(TrackedObject *object);
+    void deregisterContainer(TrackedObject *object);
+    void accountForContainer(TrackedObject *object, size_t newSize, bool accumulateDebt);
+    size_t estimateContainerSize(const TrackedObject *object) const;
 
 #if defined(DEBUG)
     friend std::ostream &operator<<(std::ostream &out, const CallFrame &f);
 #endif
 
+    Heap *_heap;
     std::atomic<bool> _haltRequested{false};
     std::vector<Value> _stack;
     std::vector<CallFrame> _frames;
-    Mapping<std::string, Value> _globals;
-    Mapping<std::string, Value> _exports;
+    std::vector<GlobalSlot> _globals;
+    Mapping<std::string, uint32_t> _globalIndices;
+    Mapping<const Bytecode *, Link> _links;
     Value _it;
 
     // Garbage collection state
-    Mapping<Object *, Weak<Object>> _trackedContainers;
-    Mapping<Object *, size_t> _containerSizes;
+    // The tracked containers, linked through the containers themselves. Young containers were
+    // created or mutated since a collection last examined them.
+    TrackedObject *_youngContainers = nullptr;
+    TrackedObject *_oldContainers = nullptr;
+    size_t _trackedContainerCount = 0;
+    size_t _youngContainerCount = 0;
     size_t _bytesSinceLastGc = 0;
     size_t _nextGcThreshold = 0;
+    size_t _nextFullGcThreshold = 0;
+    bool _fullGcRequested = false;
     size_t _liveContainerBytes = 0;
     size_t _garbageCollectionCount = 0;
+    GarbageCollectionStatistics _gcStatistics;
+    // Kept between collections so that collecting allocates nothing once they have grown.
+    Tracer _tracer{*this};
+    std::vector<Object *> _collectedObjects;
+    std::vector<Strong<Object>> _collectedContainers;
     bool _gcInProgress = false;
     bool _gcPending = false;
     bool _inNativeCall = false;
-    std::vector<Weak<Object>> _transientRoots;
+    std::vector<Strong<Object>> _transientRoots;
 };
 
 SIF_NAMESPACE_END
@@ -19,6 +19,7 @@
 #include <sif/Common.h>
 #include <sif/runtime/Object.h>
 #include <sif/runtime/Value.h>
+#include <sif/runtime/ValueMap.h>
 
 #include <sif/runtime/protocols/Copyable.h>
 #include <sif/runtime/protocols/Enumerable.h>
@@ -30,17 +31,25 @@ SIF_NAMESPACE_BEGIN
 
 class VirtualMachine;
 
-class Dictionary : public Object, public Copyable, public Enumerable, public Subscriptable {
+class Dictionary : public TrackedObject, public Copyable, public Enumerable, public Subscriptable {
   public:
+    static constexpr KindMask<Dictionary> Kinds = KindBit(Kind::Dictionary);
+
     Dictionary();
     Dictionary(const ValueMap &values);
     Dictionary(ValueMap &&values);
+    ~Dictionary() override;
 
+    // Forgets the cached hash, since the caller may change the dictionary.
     ValueMap &values();
     const ValueMap &values() const;
 
     bool contains(const Value &value) const;
 
+    // Bytes reserved for values outside the dictionary. Shared values are counted for only one of
+    // the dictionaries sharing them, as with List::reservedBytes.
+    size_t reservedBytes() const;
+
     std::string typeName() const override;
     std::string description() const override;
     std::string description(Set<const Object *> &visited) const override;
@@ -58,29 +67,61 @@ class Dictionary : public Object, public Copyable, public Enumerable, public Sub
     Result<Value, Error> setSubscript(VirtualMachine &, SourceLocation, const Value &,
                                       Value) override;
 
-    void trace(const std::function<void(Strong<Object> &)> &visitor) override;
+    // Whether the dictionary shares its values with copies of it.
+    bool isShared() const { return _shared && _shared->references() > 1; }
+
+    void trace(Tracer &tracer) override;
 
   private:
-    ValueMap _values;
+    // Values that copies of a dictionary share until one of them changes.
+    struct Shared : TrackedObject {
+        Shared(ValueMap values, const Dictionary *owner)
+            : TrackedObject(Kind::SharedStorage), values(std::move(values)), owner(owner) {}
+
+        std::string typeName() const override { return "shared dictionary"; }
+        std::string description() const override { return "shared dictionary"; }
+        void trace(Tracer &tracer) override;
+
+        ValueMap values;
+        // The dictionary that counts the values' bytes.
+        const Dictionary *owner;
+    };
+
+    Shared *shared() const { return static_cast<Shared *>(_shared.get()); }
+    // Moves the shared values into the dictionary before it changes, copying them if another
+    // dictionary still shares them. The dictionary may no longer be acyclic.
+    void detach();
+
+    // Empty while the values are shared. Mutable so that copying can move them into _shared.
+    mutable ValueMap _values;
+    mutable Strong<Object> _shared;
+    // Cached only while the dictionary holds no objects; see List::_hash.
+    mutable Optional<size_t> _hash;
 };
 
-class DictionaryEnumerator : public Enumerator {
+class DictionaryEnumerator : public TrackedObject, public Enumerator {
   public:
+    static constexpr KindMask<DictionaryEnumerator> Kinds = KindBit(Kind::DictionaryEnumerator);
+
     DictionaryEnumerator(Strong<Dictionary> dictionary);
 
     Value enumerate() override;
     bool isAtEnd() override;
 
+    // Enumerates the next entry without wrapping it in a list.
+    void enumerateEntry(Value &key, Value &value);
+
     std::string typeName() const override;
     std::string description() const override;
+    TrackedObject *container() const override { return ptr(); }
 
-    void trace(const std::function<void(Strong<Object> &)> &visitor) override;
+    void trace(Tracer &tracer) override;
 
   private:
     Dictionary *ptr() const;
 
     Strong<Object> _dictionary;
-    ValueMap::iterator _it;
+    size_t _position;
 };
 
 SIF_NAMESPACE_END
@@ -25,6 +25,8 @@ SIF_NAMESPACE_BEGIN
 
 class Function : public Object {
   public:
+    static constexpr KindMask<Function> Kinds = KindBit(Kind::Function);
+
     struct Capture {
         int index;
         bool isLocal;
@@ -39,7 +41,7 @@ class Function : public Object {
     std::string typeName() const override;
     std::string description() const override;
 
-    void trace(const std::function<void(Strong<Object> &)> &visitor) override;
+    void trace(Tracer &tracer) override;
 
   private:
     Signature _signature;
@@ -0,0 +1,102 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+#include <sif/runtime/Object.h>
+#include <sif/runtime/Value.h>
+#include <sif/runtime/ValueMap.h>
+
+#include <sif/runtime/protocols/Copyable.h>
+#include <sif/runtime/protocols/Enumerable.h>
+
+#include <string>
+
+SIF_NAMESPACE_BEGIN
+
+class VirtualMachine;
+
+// A set of values, which enumerates them in the order they were first added. The values are kept
+// as the keys of a ValueMap, with empty values.
+class HashSet : public TrackedObject, public Copyable, public Enumerable {
+  public:
+    static constexpr KindMask<HashSet> Kinds = KindBit(Kind::HashSet);
+
+    HashSet();
+    HashSet(const ValueMap &elements);
+    HashSet(ValueMap &&elements);
+
+    template <typename Iterator> HashSet(Iterator begin, Iterator end) : HashSet() {
+        for (auto it = begin; it != end; it++) {
+            _elements.emplace(*it, Value());
+        }
+    }
+
+    const ValueMap &elements() const { return _elements; }
+
+    size_t size() const { return _elements.size(); }
+    bool empty() const { return _elements.empty(); }
+
+    bool contains(const Value &value) const { return _elements.contains(value); }
+    // Returns whether the value was added, or was already in the set.
+    bool insert(const Value &value);
+    // Returns whether the value was in the set.
+    bool erase(const Value &value);
+
+    std::string typeName() const override;
+    std::string description() const override;
+    std::string description(Set<const Object *> &visited) const override;
+    bool equals(Strong<Object>) const override;
+    size_t hash() const override;
+
+    // Copyable
+    Strong<Object> copy(VirtualMachine &vm) const override;
+
+    // Enumerable
+    Value enumerator(Value self) const override;
+
+    void trace(Tracer &tracer) override;
+
+  private:
+    ValueMap _elements;
+    // Cached only while the set holds no objects; see List::_hash.
+    mutable Optional<size_t> _hash;
+};
+
+class HashSetEnumerator : public TrackedObject, public Enumerator {
+  public:
+    static constexpr KindMask<HashSetEnumerator> Kinds = KindBit(Kind::HashSetEnumerator);
+
+    HashSetEnumerator(Strong<HashSet> set);
+
+    Value enumerate() override;
+    bool isAtEnd() override;
+
+    std::string typeName() const override;
+    std::string description() const override;
+    TrackedObject *container() const override { return ptr(); }
+
+    void trace(Tracer &tracer) override;
+
+  private:
+    HashSet *ptr() const;
+
+    Strong<Object> _set;
+    size_t _position;
+};
+
+SIF_NAMESPACE_END
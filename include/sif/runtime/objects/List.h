@@ -18,6 +18,7 @@
 
 #include <sif/Common.h>
 #include <sif/runtime/Object.h>
+#include <sif/runtime/SmallVector.h>
 #include <sif/runtime/Value.h>
 #include <sif/runtime/objects/Range.h>
 
@@ -25,23 +26,72 @@
 #include <sif/runtime/protocols/Enumerable.h>
 #include <sif/runtime/protocols/Subscriptable.h>
 
+#include <algorithm>
 #include <string>
+#include <variant>
+#include <vector>
 
 SIF_NAMESPACE_BEGIN
 
 class VirtualMachine;
 
-class List : public Object, public Copyable, public Enumerable, public Subscriptable {
+class List : public TrackedObject, public Copyable, public Enumerable, public Subscriptable {
   public:
+    static constexpr KindMask<List> Kinds = KindBit(Kind::List);
+
+    // How the elements are stored. A list whose elements are all integers, or all floats, keeps
+    // them unboxed, and widens to values the first time anything else is stored in it. An empty
+    // list takes the storage of the first value stored in it.
+    enum class Storage : uint8_t { Values, Integers, Floats };
+
+    // Short lists, such as pairs, keep their elements inline and need no buffer of their own.
+    static constexpr size_t InlineBytes = 32;
+    template <typename T> using Vector = SmallVector<T, InlineBytes / sizeof(T)>;
+    using Elements = std::variant<Vector<Value>, Vector<Integer>, Vector<Float>>;
+
     List(const std::vector<Value> &values = {});
     List(std::vector<Value> &&values);
+    explicit List(Elements elements);
+    ~List() override;
+
+    template <typename Iterator>
+    List(Iterator begin, Iterator end)
+        : TrackedObject(Kind::List), _elements(Collect(begin, end)) {}
+
+    Storage storage() const { return static_cast<Storage>(elements().index()); }
+    const Elements &elements() const { return _shared ? shared()->elements : _elements; }
+
+    // Calls the visitor with the vector of unboxed elements. Visitors may reorder elements in
+    // place, but everything else that stores into the list should go through the methods below.
+    template <typename Visitor> decltype(auto) visit(Visitor &&visitor) {
+        detach();
+        _hash.reset();
+        return std::visit(std::forward<Visitor>(visitor), _elements);
+    }
+    template <typename Visitor> decltype(auto) visit(Visitor &&visitor) const {
+        return std::visit(std::forward<Visitor>(visitor), elements());
+    }
+
+    // Widens the list to value storage.
+    Vector<Value> &values();
 
-    template <typename Iterator> List(Iterator begin, Iterator end) : _values(begin, end) {}
+    size_t size() const;
+    bool empty() const { return size() == 0; }
 
-    std::vector<Value> &values();
-    const std::vector<Value> &values() const;
+    Value at(size_t index) const;
+    void set(size_t index, Value value);
+    void append(Value value);
+    void insert(size_t index, Value value);
+    void insert(size_t index, const List &list);
+    void erase(size_t begin, size_t end);
+    Elements slice(size_t begin, size_t end) const;
 
-    size_t size() const;
+    // Bytes reserved for elements outside the list, including unused capacity. Shared elements are
+    // counted for only one of the lists sharing them.
+    size_t reservedBytes() const;
+
+    // Whether the list shares its elements with copies of it.
+    bool isShared() const { return _shared && _shared->references() > 1; }
 
     void replaceAll(const Value &searchValue, const Value &replacementValue);
     void replaceFirst(const Value &searchValue, const Value &replacementValue);
@@ -71,14 +121,76 @@ class List : public Object, public Copyable, public Enumerable, public Subscript
     Result<Value, Error> setSubscript(VirtualMachine &, SourceLocation, const Value &,
                                       Value) override;
 
-    void trace(const std::function<void(Strong<Object> &)> &visitor) override;
+    void trace(Tracer &tracer) override;
 
   private:
-    std::vector<Value> _values;
+    // Elements that copies of a list share until one of them changes.
+    struct Shared : TrackedObject {
+        Shared(Elements elements, const List *owner)
+            : TrackedObject(Kind::SharedStorage), elements(std::move(elements)), owner(owner) {}
+
+        std::string typeName() const override { return "shared list"; }
+        std::string description() const override { return "shared list"; }
+        void trace(Tracer &tracer) override;
+
+        Elements elements;
+        // The list that counts the elements' bytes. When it stops sharing them, the next list
+        // to be measured counts them instead.
+        const List *owner;
+    };
+
+    static Storage StorageFor(const Value &value);
+
+    template <typename Iterator> static Elements Collect(Iterator begin, Iterator end) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(*begin)>, Value>) {
+            if (begin != end) {
+                auto storage = StorageFor(*begin);
+                if (std::all_of(begin, end, [storage](const Value &value) {
+                        return StorageFor(value) == storage;
+                    })) {
+                    switch (storage) {
+                    case Storage::Integers:
+                        return Unbox<Integer>(begin, end, &Value::asInteger);
+                    case Storage::Floats:
+                        return Unbox<Float>(begin, end, &Value::asFloat);
+                    case Storage::Values:
+                        break;
+                    }
+                }
+            }
+        }
+        return Vector<Value>(begin, end);
+    }
+
+    template <typename T, typename Iterator>
+    static Vector<T> Unbox(Iterator begin, Iterator end, T (Value::*get)() const) {
+        Vector<T> elements;
+        elements.reserve(std::distance(begin, end));
+        for (auto it = begin; it != end; it++) {
+            elements.push_back(((*it).*get)());
+        }
+        return elements;
+    }
+
+    // Prepares the storage to hold the value, widening it if necessary.
+    void accommodate(const Value &value);
+
+    Shared *shared() const { return static_cast<Shared *>(_shared.get()); }
+    // Moves the shared elements into the list before it changes, copying them if another list
+    // still shares them. The list may no longer be acyclic.
+    void detach();
+
+    // Empty while the elements are shared. Mutable so that copying can move them into _shared.
+    mutable Elements _elements;
+    mutable Strong<Object> _shared;
+    // Only lists without objects cache their hash, since objects may change without telling them.
+    mutable Optional<size_t> _hash;
 };
 
-class ListEnumerator : public Enumerator {
+class ListEnumerator : public TrackedObject, public Enumerator {
   public:
+    static constexpr KindMask<ListEnumerator> Kinds = KindBit(Kind::ListEnumerator);
+
     ListEnumerator(Strong<List> list);
 
     Value enumerate() override;
@@ -86,8 +198,9 @@ class ListEnumerator : public Enumerator {
 
     std::string typeName() const override;
     std::string description() const override;
+    TrackedObject *container() const override { return ptr(); }
 
-    void trace(const std::function<void(Strong<Object> &)> &visitor) override;
+    void trace(Tracer &tracer) override;
 
   private:
     List *ptr() const;
@@ -29,13 +29,23 @@ struct NativeCallContext {
     VirtualMachine &vm;
     SourceLocation location;
     Value *arguments;
-    std::vector<SourceRange> ranges;
+
+    // Argument ranges for calls made by the VM are decoded from the call site's debug info only
+    // when an error is reported, so successful calls don't copy them.
+    NativeCallContext(VirtualMachine &vm, SourceLocation location, Value *args,
+                      const Bytecode *bytecode, size_t callSite)
+        : vm(vm), location(location), arguments(args), _bytecode(bytecode), _callSite(callSite) {}
 
     NativeCallContext(VirtualMachine &vm, SourceLocation location, Value *args,
                       std::vector<SourceRange> ranges = {})
-        : vm(vm), location(location), arguments(args), ranges(ranges) {}
+        : vm(vm), location(location), arguments(args), _ranges(std::move(ranges)) {}
+
+    std::vector<SourceRange> ranges() const {
+        return _bytecode ? _bytecode->argumentRanges(_callSite) : _ranges;
+    }
 
     template <class... Args> Error error(std::format_string<Args...> fmt, Args &&...args) const {
+        auto ranges = this->ranges();
         if (ranges.size() > 0) {
             return Error(ranges[0], fmt, std::forward<Args>(args)...);
         } else {
@@ -45,16 +55,24 @@ struct NativeCallContext {
 
     template <class... Args>
     Error argumentError(int index, std::format_string<Args...> fmt, Args &&...args) const {
+        auto ranges = this->ranges();
         if (index >= 0 && index < ranges.size()) {
             return Error(ranges[index + 1], fmt, std::forward<Args>(args)...);
         }
         return Error(location, Format(Errors::ArgumentError, index + 1,
                                       Format(fmt, std::forward<Args>(args)...)));
     }
+
+  private:
+    const Bytecode *_bytecode = nullptr;
+    size_t _callSite = 0;
+    std::vector<SourceRange> _ranges;
 };
 
 class Native : public Object {
   public:
+    static constexpr KindMask<Native> Kinds = KindBit(Kind::Native);
+
     using Callable = std::function<Result<Value, Error>(const NativeCallContext &)>;
 
     Native(const Callable &callable);
@@ -29,6 +29,8 @@ SIF_NAMESPACE_BEGIN
 
 class Range : public Object, public Enumerable, public Subscriptable {
   public:
+    static constexpr KindMask<Range> Kinds = KindBit(Kind::Range);
+
     Range(Integer start, Integer end, bool closed);
 
     Integer start() const;
@@ -59,8 +61,10 @@ class Range : public Object, public Enumerable, public Subscriptable {
     bool _closed;
 };
 
-class RangeEnumerator : public Enumerator {
+class RangeEnumerator : public Object, public Enumerator {
   public:
+    static constexpr KindMask<RangeEnumerator> Kinds = KindBit(Kind::RangeEnumerator);
+
     RangeEnumerator(Strong<Range> range);
 
     Value enumerate() override;
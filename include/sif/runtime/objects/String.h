@@ -38,8 +38,11 @@ class String : public Object,
                public Copyable,
                public NumberCastable {
   public:
+    static constexpr KindMask<String> Kinds = KindBit(Kind::String);
+
     String(const std::string &string);
 
+    // Forgets the cached hash, since the caller may change the string.
     std::string &string();
     const std::string &string() const;
 
@@ -85,10 +88,13 @@ class String : public Object,
 
   private:
     std::string _string;
+    mutable Optional<size_t> _hash;
 };
 
-class StringEnumerator : public Enumerator {
+class StringEnumerator : public Object, public Enumerator {
   public:
+    static constexpr KindMask<StringEnumerator> Kinds = KindBit(Kind::StringEnumerator);
+
     StringEnumerator(Strong<String> list);
 
     Value enumerate() override;
@@ -23,6 +23,8 @@
 SIF_NAMESPACE_BEGIN
 
 struct NumberCastable {
+    static constexpr KindMask<NumberCastable> Kinds = KindBit(Object::Kind::String);
+
     virtual Result<Value, Error> castFloat() const = 0;
     virtual Result<Value, Error> castInteger() const = 0;
 };
@@ -24,6 +24,10 @@ SIF_NAMESPACE_BEGIN
 class VirtualMachine;
 
 struct Copyable {
+    static constexpr KindMask<Copyable> Kinds =
+        KindBit(Object::Kind::String) | KindBit(Object::Kind::List) |
+        KindBit(Object::Kind::Dictionary) | KindBit(Object::Kind::HashSet);
+
     virtual Strong<Object> copy(VirtualMachine &vm) const = 0;
 };
 
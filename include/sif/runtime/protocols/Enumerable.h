@@ -23,12 +23,25 @@
 SIF_NAMESPACE_BEGIN
 
 struct Enumerable {
+    static constexpr KindMask<Enumerable> Kinds =
+        KindBit(Object::Kind::String) | KindBit(Object::Kind::List) |
+        KindBit(Object::Kind::Dictionary) | KindBit(Object::Kind::HashSet) |
+        KindBit(Object::Kind::Range);
+
     virtual Value enumerator(Value) const = 0;
 };
 
-struct Enumerator : public Object {
+struct Enumerator {
+    static constexpr KindMask<Enumerator> Kinds =
+        KindBit(Object::Kind::StringEnumerator) | KindBit(Object::Kind::ListEnumerator) |
+        KindBit(Object::Kind::DictionaryEnumerator) | KindBit(Object::Kind::HashSetEnumerator) |
+        KindBit(Object::Kind::RangeEnumerator);
+
     virtual Value enumerate() = 0;
     virtual bool isAtEnd() = 0;
+
+    // The container being enumerated, if the enumerator holds one.
+    virtual TrackedObject *container() const { return nullptr; }
 };
 
 SIF_NAMESPACE_END
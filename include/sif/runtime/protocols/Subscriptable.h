@@ -24,6 +24,10 @@
 SIF_NAMESPACE_BEGIN
 
 struct Subscriptable {
+    static constexpr KindMask<Subscriptable> Kinds =
+        KindBit(Object::Kind::String) | KindBit(Object::Kind::List) |
+        KindBit(Object::Kind::Dictionary) | KindBit(Object::Kind::Range);
+
     virtual Result<Value, Error> subscript(VirtualMachine &, SourceLocation,
                                            const Value &) const = 0;
     virtual Result<Value, Error> setSubscript(VirtualMachine &, SourceLocation, const Value &,
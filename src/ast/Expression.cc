@@ -42,6 +42,8 @@ DictionaryLiteral::DictionaryLiteral(
     std::vector<std::pair<Strong<Expression>, Strong<Expression>>> values)
     : values(values) {}
 
+SetLiteral::SetLiteral(std::vector<Strong<Expression>> expressions) : expressions(expressions) {}
+
 Literal::Literal(Token token) : token(token) {}
 
 StringInterpolation::StringInterpolation(Token leftPart, Strong<Expression> expression,
@@ -327,6 +327,19 @@ void PrettyPrinter::visit(const DictionaryLiteral &dictionary) {
     out << "]";
 }
 
+void PrettyPrinter::visit(const SetLiteral &set) {
+    out << "{";
+    auto it = set.expressions.begin();
+    while (it != set.expressions.end()) {
+        (*it)->accept(*this);
+        it++;
+        if (it != set.expressions.end()) {
+            out << ", ";
+        }
+    }
+    out << "}";
+}
+
 void PrettyPrinter::visit(const Literal &literal) { out << literal.token.text; }
 
 void PrettyPrinter::visit(const StringInterpolation &interpolation) {
@@ -337,6 +337,19 @@ void SourceAnnotator::visit(const DictionaryLiteral &dictionary) {
     _annotations.emplace_back(dictionary.ranges.rightBracket, Annotation::Kind::Operator);
 }
 
+void SourceAnnotator::visit(const SetLiteral &set) {
+    _annotations.emplace_back(set.ranges.leftBrace, Annotation::Kind::Operator);
+    for (int i = 0; i < set.expressions.size(); i++) {
+        set.expressions[i]->accept(*this);
+        if (i < set.ranges.commas.size()) {
+            _annotations.emplace_back(set.ranges.commas[i], Annotation::Kind::Operator);
+        }
+    }
+    if (set.ranges.rightBrace) {
+        _annotations.emplace_back(set.ranges.rightBrace.value(), Annotation::Kind::Operator);
+    }
+}
+
 void SourceAnnotator::visit(const Literal &literal) {
     switch (literal.token.type) {
     case Token::Type::IntLiteral:
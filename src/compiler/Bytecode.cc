@@ -16,42 +16,100 @@
 
 #include "sif/runtime/objects/Function.h"
 #include <sif/compiler/Bytecode.h>
+#include <sif/runtime/objects/String.h>
 
 #include <sif/Utilities.h>
 
+#include <algorithm>
+#include <cassert>
 #include <climits>
 #include <cmath>
 #include <iomanip>
 
 SIF_NAMESPACE_BEGIN
 
+size_t InstructionLength(Opcode opcode) {
+    switch (opcode) {
+    case Opcode::Jump:
+    case Opcode::JumpIfFalse:
+    case Opcode::JumpIfTrue:
+    case Opcode::JumpIfAtEnd:
+    case Opcode::Repeat:
+    case Opcode::Constant:
+    case Opcode::List:
+    case Opcode::UnpackList:
+    case Opcode::Dictionary:
+    case Opcode::Set:
+    case Opcode::Short:
+    case Opcode::SetGlobal:
+    case Opcode::GetGlobal:
+    case Opcode::SetLocal:
+    case Opcode::GetLocal:
+    case Opcode::SetCapture:
+    case Opcode::GetCapture:
+    case Opcode::Call:
+    case Opcode::PushJump:
+    case Opcode::JumpIfCountAtEnd:
+    case Opcode::GetLocalGetLocal:
+    case Opcode::GetLocalShort:
+    case Opcode::JumpIfFalsePop:
+    case Opcode::CallSetIt:
+    case Opcode::ListReturn:
+        return 3;
+    case Opcode::RegisterMove:
+        return 5;
+    case Opcode::RegisterAdd:
+    case Opcode::RegisterSubtract:
+    case Opcode::RegisterMultiply:
+    case Opcode::RegisterDivide:
+    case Opcode::RegisterModulo:
+    case Opcode::RegisterEqual:
+    case Opcode::RegisterNotEqual:
+    case Opcode::RegisterLessThan:
+    case Opcode::RegisterGreaterThan:
+    case Opcode::RegisterLessThanOrEqual:
+    case Opcode::RegisterGreaterThanOrEqual:
+        return 7;
+    default:
+        return 1;
+    }
+}
+
 size_t Bytecode::add(SourceLocation location, Opcode opcode) {
+    addLocation(_code.size(), location);
     _code.push_back(opcode);
-    _locations.push_back(location);
     return _code.size() - 1;
 }
 
 size_t Bytecode::add(SourceLocation location, Opcode opcode, uint16_t argument) {
+    addLocation(_code.size(), location);
     _code.push_back(opcode);
     _code.push_back(static_cast<Opcode>(argument >> 8));
     _code.push_back(static_cast<Opcode>(argument & 0xff));
-    _locations.push_back(location);
-    _locations.push_back(location);
-    _locations.push_back(location);
     return _code.size() - 3;
 }
 
+size_t Bytecode::add(SourceLocation location, Opcode opcode,
+                     std::initializer_list<uint16_t> operands) {
+    auto start = _code.size();
+    addLocation(start, location);
+    _code.push_back(opcode);
+    for (auto operand : operands) {
+        _code.push_back(static_cast<Opcode>(operand >> 8));
+        _code.push_back(static_cast<Opcode>(operand & 0xff));
+    }
+    return start;
+}
+
 void Bytecode::addRepeat(SourceLocation location, uint16_t argument) {
     auto offset = _code.size() - argument + 3;
     if (offset > USHRT_MAX) {
         throw std::out_of_range(Concat("jump too far (", SHRT_MAX, ")"));
     }
+    addLocation(_code.size(), location);
     _code.push_back(Opcode::Repeat);
     _code.push_back(static_cast<Opcode>(offset >> 8));
     _code.push_back(static_cast<Opcode>(offset & 0xff));
-    _locations.push_back(location);
-    _locations.push_back(location);
-    _locations.push_back(location);
 }
 
 uint16_t Bytecode::addLocal(std::string local) {
@@ -71,16 +129,46 @@ uint16_t Bytecode::addLocal(std::string local) {
     return _locals.size() - 1;
 }
 
+// Constants are shared when they have the same type and value. Strings compare by contents and
+// other objects by identity, so interning never hashes or compares the elements of a container.
+static size_t ConstantHash(const Value &value) {
+    if (auto string = value.as<String>()) {
+        return std::hash<std::string>{}(string->string());
+    }
+    if (value.isObject()) {
+        return std::hash<const Object *>{}(value.asObject().get());
+    }
+    return Value::Hash{}(value);
+}
+
+static bool SameConstant(const Value &lhs, const Value &rhs) {
+    if (lhs.type() != rhs.type()) {
+        return false;
+    }
+    if (lhs.isObject()) {
+        auto lhsString = lhs.as<String>();
+        auto rhsString = rhs.as<String>();
+        if (lhsString || rhsString) {
+            return lhsString && rhsString && lhsString->string() == rhsString->string();
+        }
+        return lhs.asObject() == rhs.asObject();
+    }
+    return lhs == rhs;
+}
+
 uint16_t Bytecode::addConstant(const Value &constant) {
-    for (int i = 0; i < _constants.size(); i++) {
-        if (_constants[i] == constant) {
-            return i;
+    auto hash = ConstantHash(constant);
+    auto [begin, end] = _constantIndices.equal_range(hash);
+    for (auto it = begin; it != end; it++) {
+        if (SameConstant(_constants[it->second], constant)) {
+            return it->second;
         }
     }
-    _constants.push_back(constant);
-    if (_constants.size() > USHRT_MAX) {
+    if (_constants.size() >= USHRT_MAX) {
         throw std::out_of_range(Concat("too many constants (", USHRT_MAX, ")"));
     }
+    _constants.push_back(constant);
+    _constantIndices.emplace(hash, _constants.size() - 1);
     return _constants.size() - 1;
 }
 
@@ -114,6 +202,47 @@ void Bytecode::patchAbsoluteJump(size_t index) {
     _code[index + 2] = static_cast<Opcode>(destination & 0xff);
 }
 
+static Optional<Opcode> Superinstruction(Opcode first, Opcode second) {
+    if (first == Opcode::GetLocal && second == Opcode::GetLocal) {
+        return Opcode::GetLocalGetLocal;
+    }
+    if (first == Opcode::GetLocal && second == Opcode::Short) {
+        return Opcode::GetLocalShort;
+    }
+    if (first == Opcode::JumpIfFalse && second == Opcode::Pop) {
+        return Opcode::JumpIfFalsePop;
+    }
+    if (first == Opcode::Call && second == Opcode::SetIt) {
+        return Opcode::CallSetIt;
+    }
+    if (first == Opcode::List && second == Opcode::Return) {
+        return Opcode::ListReturn;
+    }
+    if (first == Opcode::Enumerate && second == Opcode::UnpackList) {
+        return Opcode::EnumerateUnpackList;
+    }
+    return None;
+}
+
+void Bytecode::fuseSuperinstructions() {
+    // Fusing only rewrites the first opcode of a pair, so every instruction can be considered
+    // independently as long as pairs are matched against the original opcodes.
+    std::vector<size_t> starts;
+    for (size_t i = 0; i < _code.size(); i += InstructionLength(_code[i])) {
+        starts.push_back(i);
+    }
+    std::vector<Opcode> original;
+    original.reserve(starts.size());
+    for (auto start : starts) {
+        original.push_back(_code[start]);
+    }
+    for (size_t i = 0; i + 1 < starts.size(); i++) {
+        if (auto fused = Superinstruction(original[i], original[i + 1])) {
+            _code[starts[i]] = fused.value();
+        }
+    }
+}
+
 const std::vector<Opcode> &Bytecode::code() const { return _code; }
 
 const std::vector<std::string> &Bytecode::locals() const { return _locals; }
@@ -122,18 +251,100 @@ const std::vector<Value> &Bytecode::constants() const { return _constants; }
 
 std::vector<Value> &Bytecode::constants() { return _constants; }
 
-SourceLocation Bytecode::location(Iterator it) const { return _locations[it - _code.begin()]; }
+// Line table entries are varints: the distance in code from the previous entry, followed by the
+// zigzag encoded differences of the line number, position and offset.
+static void AppendVarint(std::vector<uint8_t> &table, uint64_t value) {
+    while (value >= 0x80) {
+        table.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    table.push_back(static_cast<uint8_t>(value));
+}
+
+static uint64_t ReadVarint(const std::vector<uint8_t> &table, size_t &index) {
+    uint64_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        auto byte = table[index++];
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+}
+
+static void AppendDelta(std::vector<uint8_t> &table, unsigned int from, unsigned int to) {
+    auto delta = static_cast<int64_t>(to) - static_cast<int64_t>(from);
+    AppendVarint(table, (static_cast<uint64_t>(delta) << 1) ^ static_cast<uint64_t>(delta >> 63));
+}
+
+static unsigned int ReadDelta(const std::vector<uint8_t> &table, size_t &index,
+                              unsigned int from) {
+    auto value = ReadVarint(table, index);
+    auto delta = static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    return static_cast<unsigned int>(from + delta);
+}
+
+void Bytecode::addLocation(size_t position, SourceLocation location) {
+    const auto &last = _lastLine;
+    if (_lineEntries > 0 && last.location == location) {
+        return;
+    }
+    AppendVarint(_lineTable, position - last.position);
+    AppendDelta(_lineTable, last.location.lineNumber, location.lineNumber);
+    AppendDelta(_lineTable, last.location.position, location.position);
+    AppendDelta(_lineTable, last.location.offset, location.offset);
+    _lastLine = {static_cast<uint32_t>(position), static_cast<uint32_t>(_lineTable.size()),
+                 location};
+    if (_lineEntries++ % LineCheckpointInterval == 0) {
+        _lineCheckpoints.push_back(_lastLine);
+    }
+}
+
+SourceLocation Bytecode::location(Iterator it) const {
+    size_t position = it - _code.begin();
+    auto checkpoint = std::upper_bound(
+        _lineCheckpoints.begin(), _lineCheckpoints.end(), position,
+        [](size_t position, const LineState &state) { return position < state.position; });
+    if (checkpoint == _lineCheckpoints.begin()) {
+        return SourceLocation();
+    }
+    auto state = *(checkpoint - 1);
+    while (state.index < _lineTable.size()) {
+        size_t index = state.index;
+        auto next = static_cast<uint32_t>(state.position + ReadVarint(_lineTable, index));
+        if (next > position) {
+            break;
+        }
+        state.position = next;
+        state.location.lineNumber = ReadDelta(_lineTable, index, state.location.lineNumber);
+        state.location.position = ReadDelta(_lineTable, index, state.location.position);
+        state.location.offset = ReadDelta(_lineTable, index, state.location.offset);
+        state.index = static_cast<uint32_t>(index);
+    }
+    return state.location;
+}
 
 void Bytecode::addArgumentRanges(size_t callLocation, const std::vector<SourceRange> &ranges) {
-    _argumentRanges[callLocation] = ranges;
+    // Calls are compiled in code order, so the index stays sorted by call location.
+    assert((_argumentRangeIndex.empty() || _argumentRangeIndex.back().first < callLocation) &&
+           "argument ranges added out of code order");
+    _argumentRangeIndex.emplace_back(callLocation, _argumentRanges.size());
+    _argumentRanges.insert(_argumentRanges.end(), ranges.begin(), ranges.end());
 }
 
 std::vector<SourceRange> Bytecode::argumentRanges(size_t callLocation) const {
-    auto it = _argumentRanges.find(callLocation);
-    if (it != _argumentRanges.end()) {
-        return it->second;
+    auto it = std::lower_bound(
+        _argumentRangeIndex.begin(), _argumentRangeIndex.end(), callLocation,
+        [](const std::pair<size_t, size_t> &entry, size_t location) {
+            return entry.first < location;
+        });
+    if (it == _argumentRangeIndex.end() || it->first != callLocation) {
+        return {};
     }
-    return {};
+    auto begin = _argumentRanges.begin() + it->second;
+    auto end = it + 1 == _argumentRangeIndex.end() ? _argumentRanges.end()
+                                                   : _argumentRanges.begin() + (it + 1)->second;
+    return std::vector<SourceRange>(begin, end);
 }
 
 static inline uint16_t ReadUInt16(Bytecode::Iterator position) {
@@ -156,9 +367,10 @@ Bytecode::Iterator Bytecode::disassembleConstant(std::ostream &out, const std::s
     return position + 3;
 }
 
-Bytecode::Iterator Bytecode::disassembleList(std::ostream &out, Iterator position) const {
+Bytecode::Iterator Bytecode::disassembleList(std::ostream &out, const std::string &name,
+                                             Iterator position) const {
     size_t count = ReadUInt16(position + 1);
-    out << "List " << count;
+    out << name << " " << count;
     return position + 3;
 }
 
@@ -208,6 +420,24 @@ Bytecode::Iterator Bytecode::disassembleLocal(std::ostream &out, const std::stri
     return position + 3;
 }
 
+Bytecode::Iterator Bytecode::disassembleRegisters(std::ostream &out, const std::string &name,
+                                                  Iterator position) const {
+    out << name;
+    auto end = position + InstructionLength(*position);
+    for (auto operand = position + 1; operand < end; operand += 2) {
+        uint16_t value = ReadUInt16(operand);
+        out << (operand == position + 1 ? " " : ", ");
+        if (value == RegisterStack) {
+            out << "stack";
+        } else if (value >= RegisterConstant) {
+            out << _constants.at(value - RegisterConstant).debugDescription();
+        } else {
+            out << "r" << value;
+        }
+    }
+    return end;
+}
+
 Bytecode::Iterator Bytecode::disassemble(std::ostream &out, Iterator position) const {
     auto opcode = *position;
     switch (opcode) {
@@ -243,11 +473,13 @@ Bytecode::Iterator Bytecode::disassemble(std::ostream &out, Iterator position) c
         out << "ClosedRange";
         return position + 1;
     case Opcode::List:
-        return disassembleList(out, position);
+        return disassembleList(out, "List", position);
     case Opcode::UnpackList:
         return disassembleUnpackList(out, position);
     case Opcode::Dictionary:
         return disassembleDictionary(out, position);
+    case Opcode::Set:
+        return disassembleList(out, "Set", position);
     case Opcode::GetGlobal:
         return disassembleConstant(out, "GetGlobal", position);
     case Opcode::SetGlobal:
@@ -340,6 +572,54 @@ Bytecode::Iterator Bytecode::disassemble(std::ostream &out, Iterator position) c
     case Opcode::ToString:
         out << "ToString";
         return position + 1;
+    case Opcode::OpenCountedRange:
+        out << "OpenCountedRange";
+        return position + 1;
+    case Opcode::ClosedCountedRange:
+        out << "ClosedCountedRange";
+        return position + 1;
+    case Opcode::JumpIfCountAtEnd:
+        return disassembleJump(out, "JumpIfCountAtEnd", position);
+    case Opcode::NextCount:
+        out << "NextCount";
+        return position + 1;
+    case Opcode::RegisterMove:
+        return disassembleRegisters(out, "RegisterMove", position);
+    case Opcode::RegisterAdd:
+        return disassembleRegisters(out, "RegisterAdd", position);
+    case Opcode::RegisterSubtract:
+        return disassembleRegisters(out, "RegisterSubtract", position);
+    case Opcode::RegisterMultiply:
+        return disassembleRegisters(out, "RegisterMultiply", position);
+    case Opcode::RegisterDivide:
+        return disassembleRegisters(out, "RegisterDivide", position);
+    case Opcode::RegisterModulo:
+        return disassembleRegisters(out, "RegisterModulo", position);
+    case Opcode::RegisterEqual:
+        return disassembleRegisters(out, "RegisterEqual", position);
+    case Opcode::RegisterNotEqual:
+        return disassembleRegisters(out, "RegisterNotEqual", position);
+    case Opcode::RegisterLessThan:
+        return disassembleRegisters(out, "RegisterLessThan", position);
+    case Opcode::RegisterGreaterThan:
+        return disassembleRegisters(out, "RegisterGreaterThan", position);
+    case Opcode::RegisterLessThanOrEqual:
+        return disassembleRegisters(out, "RegisterLessThanOrEqual", position);
+    case Opcode::RegisterGreaterThanOrEqual:
+        return disassembleRegisters(out, "RegisterGreaterThanOrEqual", position);
+    case Opcode::GetLocalGetLocal:
+        return disassembleLocal(out, "GetLocalGetLocal", position);
+    case Opcode::GetLocalShort:
+        return disassembleLocal(out, "GetLocalShort", position);
+    case Opcode::JumpIfFalsePop:
+        return disassembleJump(out, "JumpIfFalsePop", position);
+    case Opcode::CallSetIt:
+        return disassembleCall(out, "CallSetIt", position);
+    case Opcode::ListReturn:
+        return disassembleList(out, "ListReturn", position);
+    case Opcode::EnumerateUnpackList:
+        out << "EnumerateUnpackList";
+        return position + 1;
     }
     // Unreachable, but GCC requires a return statement
     return position;
@@ -33,6 +33,7 @@ Strong<Bytecode> Compiler::compile(const Statement &statement) {
 
     statement.accept(*this);
     addImplicitReturnIfNeeded();
+    bytecode().fuseSuperinstructions();
 
     return _failed ? nullptr : _frames.back().bytecode;
 }
@@ -217,6 +218,193 @@ void Compiler::resolve(const Variable &variable, const std::string &name) {
     bytecode().add(variable.range.start, opcode, index);
 }
 
+static inline Value valueOf(const Token &token) {
+    switch (token.type) {
+    case Token::Type::StringLiteral:
+    case Token::Type::ClosedInterpolation:
+        return token.encodedString();
+    case Token::Type::IntLiteral:
+        return std::stol(token.text);
+    case Token::Type::FloatLiteral:
+        return std::stod(token.text);
+    default:
+        Abort("unexpected token literal ", RawValue(token.type));
+    }
+}
+
+static Optional<Opcode> RegisterOpcode(Binary::Operator binaryOperator) {
+    switch (binaryOperator) {
+    case Binary::Operator::Plus:
+        return Opcode::RegisterAdd;
+    case Binary::Operator::Minus:
+        return Opcode::RegisterSubtract;
+    case Binary::Operator::Multiply:
+        return Opcode::RegisterMultiply;
+    case Binary::Operator::Divide:
+        return Opcode::RegisterDivide;
+    case Binary::Operator::Modulo:
+        return Opcode::RegisterModulo;
+    case Binary::Operator::Equal:
+        return Opcode::RegisterEqual;
+    case Binary::Operator::NotEqual:
+        return Opcode::RegisterNotEqual;
+    case Binary::Operator::LessThan:
+        return Opcode::RegisterLessThan;
+    case Binary::Operator::GreaterThan:
+        return Opcode::RegisterGreaterThan;
+    case Binary::Operator::LessThanOrEqual:
+        return Opcode::RegisterLessThanOrEqual;
+    case Binary::Operator::GreaterThanOrEqual:
+        return Opcode::RegisterGreaterThanOrEqual;
+    default:
+        return None;
+    }
+}
+
+Optional<uint16_t> Compiler::registerOperand(const Expression &expression) {
+    if (auto grouping = dynamic_cast<const Grouping *>(&expression)) {
+        return grouping->expression ? registerOperand(*grouping->expression) : None;
+    }
+
+    // Only locals of the current frame; captures and globals keep their own instructions.
+    if (auto variable = dynamic_cast<const Variable *>(&expression)) {
+        if (!variable->name || variable->scope == Variable::Scope::Global) {
+            return None;
+        }
+        if (_config.interactive && _scopeDepth == 0 && variable->scope != Variable::Scope::Local) {
+            return None;
+        }
+        auto name = NormalizeIdentifier(variable->name->text);
+        if (name == "it") {
+            return None;
+        }
+        int index = findLocal(_frames.back(), name);
+        if (index < 0 || index >= RegisterConstant) {
+            return None;
+        }
+        return static_cast<uint16_t>(index);
+    }
+
+    // Only numbers and bools, which are never copied when read from the constant table.
+    if (auto literal = dynamic_cast<const Literal *>(&expression)) {
+        Value value;
+        try {
+            switch (literal->token.type) {
+            case Token::Type::IntLiteral:
+            case Token::Type::FloatLiteral:
+                value = valueOf(literal->token);
+                break;
+            case Token::Type::BoolLiteral:
+                value = lowercase(literal->token.text) == "true" ||
+                        lowercase(literal->token.text) == "yes";
+                break;
+            default:
+                return None;
+            }
+        } catch (const std::out_of_range &) {
+            return None;
+        }
+        auto index = bytecode().addConstant(value);
+        if (index >= RegisterStack - RegisterConstant) {
+            return None;
+        }
+        return static_cast<uint16_t>(RegisterConstant + index);
+    }
+    return None;
+}
+
+// Whether evaluating an expression can't run code that reassigns a local.
+static bool IsPure(const Expression *expression) {
+    if (auto grouping = dynamic_cast<const Grouping *>(expression)) {
+        return IsPure(grouping->expression.get());
+    }
+    if (auto unary = dynamic_cast<const Unary *>(expression)) {
+        return IsPure(unary->expression.get());
+    }
+    if (auto binary = dynamic_cast<const Binary *>(expression)) {
+        return IsPure(binary->leftExpression.get()) && IsPure(binary->rightExpression.get());
+    }
+    return dynamic_cast<const Variable *>(expression) || dynamic_cast<const Literal *>(expression);
+}
+
+std::pair<uint16_t, uint16_t> Compiler::registerOperands(const Binary &binary) {
+    // A register is read when the instruction executes, so the left operand can only be named
+    // directly if evaluating the right operand can't reassign it.
+    auto rhs = registerOperand(*binary.rightExpression);
+    Optional<uint16_t> lhs;
+    if (rhs || IsPure(binary.rightExpression.get())) {
+        lhs = registerOperand(*binary.leftExpression);
+    }
+    if (!lhs) {
+        binary.leftExpression->accept(*this);
+    }
+    if (!rhs) {
+        binary.rightExpression->accept(*this);
+    }
+    return {lhs.value_or(RegisterStack), rhs.value_or(RegisterStack)};
+}
+
+bool Compiler::assignRegister(const Assignment &assignment) {
+    if (assignment.targets.size() != 1) {
+        return false;
+    }
+    auto target = dynamic_cast<const VariableTarget *>(assignment.targets[0].get());
+    if (!target || !target->variable->name || target->subscripts.size() > 0) {
+        return false;
+    }
+    auto name = NormalizeIdentifier(target->variable->name->text);
+    if (name == "it") {
+        return false;
+    }
+
+    // Mirrors assignVariable: only assignments to a local of the current frame qualify.
+    auto scope = target->variable->scope;
+    if (scope == Variable::Scope::Global ||
+        (!scope && _scopeDepth == 0 && _config.interactive)) {
+        return false;
+    }
+    int index = findLocal(_frames.back(), name);
+    if (index < 0 && (findCapture(name) > -1 || locals().size() >= RegisterConstant)) {
+        return false;
+    }
+
+    auto binary = dynamic_cast<const Binary *>(assignment.expression.get());
+    auto opcode = binary ? RegisterOpcode(binary->binaryOperator) : None;
+    Optional<uint16_t> source;
+    if (!opcode) {
+        source = registerOperand(*assignment.expression);
+        if (!source) {
+            return false;
+        }
+    }
+
+    // Operands are resolved before a new local is declared, so `set x to x + 1` still reads the
+    // outer x.
+    std::pair<uint16_t, uint16_t> operands;
+    if (opcode) {
+        operands = registerOperands(*binary);
+    }
+    if (index < 0) {
+        addLocal(name);
+        index = static_cast<int>(locals().size()) - 1;
+    }
+    auto destination = static_cast<uint16_t>(index);
+    if (opcode) {
+        bytecode().add(binary->range.start, opcode.value(),
+                       {destination, operands.first, operands.second});
+    } else {
+        bytecode().add(target->variable->range.start, Opcode::RegisterMove,
+                       {destination, source.value()});
+    }
+    return true;
+}
+
+void Compiler::markLiteral(uint16_t index) {
+    if (auto string = bytecode().constants()[index].as<String>()) {
+        string->literal = true;
+    }
+}
+
 void Compiler::addImplicitReturnIfNeeded() {
     if (bytecode().code().size() == 0 || bytecode().code().back() != Opcode::Return) {
         bytecode().add(SourceLocation{0, 0}, Opcode::GetIt);
@@ -288,6 +476,7 @@ void Compiler::visit(const FunctionDecl &functionDecl) {
 
     // Add implicit return statement if necessary.
     addImplicitReturnIfNeeded();
+    bytecode().fuseSuperinstructions();
 
     auto functionCaptures = captures();
     _frames.pop_back();
@@ -367,6 +556,9 @@ void Compiler::visit(const Return &statement) {
 }
 
 void Compiler::visit(const Assignment &assignment) {
+    if (_config.registerInstructions && assignRegister(assignment)) {
+        return;
+    }
     assignment.expression->accept(*this);
     if (assignment.targets.size() > 1) {
         uint16_t count;
@@ -464,10 +656,23 @@ void Compiler::visit(const RepeatFor &foreach) {
     auto nextRepeat = _nextRepeat;
     _exitPatches.push({});
 
-    foreach.expression->accept(*this);
-    bytecode().add(foreach.expression->range.start, Opcode::GetEnumerator);
-    _nextRepeat = bytecode().add(foreach.expression->range.start, Opcode::JumpIfAtEnd, 0);
-    bytecode().add(foreach.expression->range.start, Opcode::Enumerate);
+    // Literal ranges with a single loop variable keep the counter and its last value as
+    // integers on the stack instead of allocating a Range and its enumerator.
+    auto range = dynamic_cast<const RangeLiteral *>(foreach.expression.get());
+    bool counted = range && range->start && range->end && foreach.variables.size() == 1;
+    if (counted) {
+        range->start->accept(*this);
+        range->end->accept(*this);
+        bytecode().add(range->range.start,
+                       range->closed ? Opcode::ClosedCountedRange : Opcode::OpenCountedRange);
+        _nextRepeat = bytecode().add(foreach.expression->range.start, Opcode::JumpIfCountAtEnd, 0);
+        bytecode().add(foreach.expression->range.start, Opcode::NextCount);
+    } else {
+        foreach.expression->accept(*this);
+        bytecode().add(foreach.expression->range.start, Opcode::GetEnumerator);
+        _nextRepeat = bytecode().add(foreach.expression->range.start, Opcode::JumpIfAtEnd, 0);
+        bytecode().add(foreach.expression->range.start, Opcode::Enumerate);
+    }
     if (foreach.variables.size() > 1) {
         bytecode().add(foreach.expression->range.start, Opcode::UnpackList,
                        foreach.variables.size());
@@ -484,6 +689,9 @@ void Compiler::visit(const RepeatFor &foreach) {
     bytecode().addRepeat(foreach.range.start, _nextRepeat);
     auto popLocation = bytecode().code().size();
     bytecode().add(foreach.range.start, Opcode::Pop);
+    if (counted) {
+        bytecode().add(foreach.range.start, Opcode::Pop);
+    }
     bytecode().patchRelativeJumpTo(_nextRepeat, popLocation);
     for (auto location : _exitPatches.top()) {
         bytecode().patchRelativeJumpTo(location, popLocation);
@@ -563,6 +771,14 @@ void Compiler::visit(const Binary &binary) {
         return;
     }
 
+    if (_config.registerInstructions) {
+        if (auto opcode = RegisterOpcode(binary.binaryOperator)) {
+            auto [lhs, rhs] = registerOperands(binary);
+            bytecode().add(binary.range.start, opcode.value(), {RegisterStack, lhs, rhs});
+            return;
+        }
+    }
+
     binary.leftExpression->accept(*this);
     binary.rightExpression->accept(*this);
     switch (binary.binaryOperator) {
@@ -649,18 +865,11 @@ void Compiler::visit(const DictionaryLiteral &dictionary) {
     bytecode().add(dictionary.range.start, Opcode::Dictionary, dictionary.values.size());
 }
 
-static inline Value valueOf(const Token &token) {
-    switch (token.type) {
-    case Token::Type::StringLiteral:
-    case Token::Type::ClosedInterpolation:
-        return token.encodedString();
-    case Token::Type::IntLiteral:
-        return std::stol(token.text);
-    case Token::Type::FloatLiteral:
-        return std::stod(token.text);
-    default:
-        Abort("unexpected token literal ", RawValue(token.type));
+void Compiler::visit(const SetLiteral &set) {
+    for (const auto &expression : set.expressions) {
+        expression->accept(*this);
     }
+    bytecode().add(set.range.start, Opcode::Set, set.expressions.size());
 }
 
 void Compiler::visit(const Literal &literal) {
@@ -689,6 +898,7 @@ void Compiler::visit(const Literal &literal) {
 
     try {
         auto index = bytecode().addConstant(valueOf(literal.token));
+        markLiteral(index);
         bytecode().add(literal.range.start, Opcode::Constant, index);
     } catch (const std::out_of_range &) {
         error(literal, Format(Errors::ValueOutOfRange));
@@ -697,6 +907,7 @@ void Compiler::visit(const Literal &literal) {
 
 void Compiler::visit(const StringInterpolation &interpolation) {
     auto leftIndex = bytecode().addConstant(interpolation.left.encodedString());
+    markLiteral(leftIndex);
     bytecode().add(interpolation.range.start, Opcode::Constant, leftIndex);
 
     interpolation.expression->accept(*this);
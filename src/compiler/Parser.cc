@@ -1640,6 +1640,16 @@ Strong<Expression> Parser::parsePrimary() {
         return container;
     }
 
+    if (match({Token::Type::LeftBrace})) {
+        auto ignoreNewLines = _config.scanner.ignoreNewLines;
+        _config.scanner.ignoreNewLines = true;
+
+        auto set = parseSetLiteral();
+
+        _config.scanner.ignoreNewLines = ignoreNewLines;
+        return set;
+    }
+
     if (peek().isWord() || peek().type == Token::Type::Global ||
         peek().type == Token::Type::Local) {
         return parseVariable();
@@ -1831,4 +1841,30 @@ Strong<Expression> Parser::parseContainerLiteral() {
     return containerExpression;
 }
 
+Strong<Expression> Parser::parseSetLiteral() {
+    auto set = MakeStrong<SetLiteral>();
+    set->ranges.leftBrace = previous().range;
+    set->range.start = previous().range.start;
+
+    if (!check({Token::Type::RightBrace})) {
+        do {
+            if (!set->expressions.empty()) {
+                set->ranges.commas.push_back(previous().range);
+            }
+            auto expression = parseTerm();
+            if (!expression) {
+                return set;
+            }
+            set->expressions.push_back(expression);
+        } while (match({Token::Type::Comma}));
+    }
+    if (!consume(Token::Type::RightBrace)) {
+        emitError(Error(peek().range, Errors::ExpectedRightCurlyBrace));
+        return set;
+    }
+    set->ranges.rightBrace = previous().range;
+    set->range.end = previous().range.end;
+    return set;
+}
+
 SIF_NAMESPACE_END
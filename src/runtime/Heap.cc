@@ -0,0 +1,168 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "sif/runtime/Heap.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+SIF_NAMESPACE_BEGIN
+
+// Slabs are aligned to their size, so the slab holding a cell is found by masking its address.
+struct Heap::Slab {
+    Heap *heap;
+    Slab *next;
+    size_t cellSize;
+};
+
+Heap::~Heap() {
+    while (_slabs) {
+        auto next = _slabs->next;
+        std::free(_slabs);
+        _slabs = next;
+    }
+}
+
+void Heap::abandon() {
+    _abandoned = true;
+    freeIfAbandoned();
+}
+
+// Other thread-local destructors may allocate and free objects after the thread's heap is given
+// up, so it is never handed out again once the thread has exited.
+Heap *Heap::ThreadHeap() {
+    struct Owner {
+        ~Owner() {
+            _threadExited = true;
+            std::exchange(_threadHeap, nullptr)->abandon();
+        }
+    };
+    if (!_threadHeap && !_threadExited) {
+        static thread_local Owner owner;
+        _threadHeap = new Heap();
+    }
+    return _threadHeap;
+}
+
+void *Heap::Allocate(size_t size) {
+    auto heap = _current ? _current : ThreadHeap();
+    if (!heap) {
+        // An object allocated after its thread exited gets a heap of its own, freed with it.
+        heap = new Heap();
+        heap->_abandoned = true;
+    }
+    return size > MaximumCellSize ? heap->allocateLarge(size) : heap->allocate(size);
+}
+
+void Heap::Deallocate(void *pointer, size_t size) {
+    if (!pointer) {
+        return;
+    }
+    if (size > MaximumCellSize) {
+        auto object = static_cast<LargeObject *>(pointer) - 1;
+        object->heap->deallocateLarge(object);
+        return;
+    }
+    auto slab = reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(pointer) & ~(SlabSize - 1));
+    slab->heap->deallocate(slab, pointer);
+}
+
+void *Heap::allocate(size_t size) {
+    auto sizeClass = size == 0 ? 0 : (size - 1) / CellAlignment;
+    auto cellSize = (sizeClass + 1) * CellAlignment;
+    void *pointer;
+    if (auto cell = _freeLists[sizeClass]) {
+        _freeLists[sizeClass] = cell->next;
+        pointer = cell;
+    } else {
+        if (_limits[sizeClass] - _cursors[sizeClass] < static_cast<ptrdiff_t>(cellSize)) {
+            auto base = reinterpret_cast<char *>(makeSlab(cellSize));
+            _cursors[sizeClass] = base + SlabHeaderSize;
+            _limits[sizeClass] = base + SlabSize;
+        }
+        pointer = _cursors[sizeClass];
+        _cursors[sizeClass] += cellSize;
+    }
+    _statistics.allocations++;
+    _statistics.liveObjects++;
+    _statistics.liveBytes += cellSize;
+    return pointer;
+}
+
+void *Heap::allocateLarge(size_t size) {
+    auto bytes = sizeof(LargeObject) + size;
+    auto memory = std::malloc(bytes);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    auto object = new (memory) LargeObject{this, bytes};
+    reserve(bytes);
+    _statistics.allocations++;
+    _statistics.liveObjects++;
+    _statistics.liveBytes += size;
+    return object + 1;
+}
+
+void Heap::deallocate(Slab *slab, void *pointer) {
+    _statistics.deallocations++;
+    _statistics.liveObjects--;
+    _statistics.liveBytes -= slab->cellSize;
+    auto cell = static_cast<Cell *>(pointer);
+    auto sizeClass = slab->cellSize / CellAlignment - 1;
+    cell->next = _freeLists[sizeClass];
+    _freeLists[sizeClass] = cell;
+    freeIfAbandoned();
+}
+
+void Heap::deallocateLarge(LargeObject *object) {
+    _statistics.deallocations++;
+    _statistics.liveObjects--;
+    _statistics.liveBytes -= object->bytes - sizeof(LargeObject);
+    _statistics.reservedBytes -= object->bytes;
+    std::free(object);
+    freeIfAbandoned();
+}
+
+void Heap::freeIfAbandoned() {
+    if (_abandoned && _statistics.liveObjects == 0) {
+        delete this;
+    }
+}
+
+Heap::Slab *Heap::makeSlab(size_t cellSize) {
+    static_assert(sizeof(Slab) <= SlabHeaderSize, "slab header overlaps its cells");
+    auto memory = std::aligned_alloc(SlabSize, SlabSize);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+    auto slab = new (memory) Slab{this, _slabs, cellSize};
+    _slabs = slab;
+    _statistics.slabs++;
+    reserve(SlabSize);
+    return slab;
+}
+
+void Heap::reserve(size_t bytes) {
+    _statistics.reservedBytes += bytes;
+    _statistics.peakReservedBytes =
+        std::max(_statistics.peakReservedBytes, _statistics.reservedBytes);
+}
+
+SIF_NAMESPACE_END
@@ -15,9 +15,40 @@
 //
 
 #include "sif/runtime/Object.h"
+#include "sif/runtime/Heap.h"
+#include "sif/runtime/VirtualMachine.h"
+#include "sif/runtime/objects/Dictionary.h"
+#include "sif/runtime/objects/HashSet.h"
+#include "sif/runtime/objects/List.h"
+#include "sif/runtime/objects/Range.h"
+#include "sif/runtime/objects/String.h"
+#include "sif/runtime/protocols/Castable.h"
+#include "sif/runtime/protocols/Copyable.h"
+#include "sif/runtime/protocols/Enumerable.h"
+#include "sif/runtime/protocols/Subscriptable.h"
 
 SIF_NAMESPACE_BEGIN
 
+void *Object::operator new(size_t size) { return Heap::Allocate(size); }
+
+void Object::operator delete(void *pointer, size_t size) { Heap::Deallocate(pointer, size); }
+
+TrackedObject::~TrackedObject() {
+    if (tracker) {
+        tracker->deregisterContainer(this);
+    }
+}
+
+void TrackedObject::bufferCycleCandidate() const {
+    auto *object = const_cast<TrackedObject *>(this);
+    if (!tracker) {
+        object = ObjectCast<Enumerator>(object)->container();
+    }
+    if (object && object->tracker && !object->acyclic) {
+        object->tracker->rememberContainer(object);
+    }
+}
+
 bool Object::equals(Strong<Object> object) const { return this == object.get(); }
 
 size_t Object::hash() const { return reinterpret_cast<size_t>(this); }
@@ -28,6 +59,50 @@ std::string Object::description(Set<const Object *> &visited) const { return des
 
 std::string Object::debugDescription() const { return description(); }
 
+template <class Protocol, class Class> static Protocol *Upcast(Object *object) {
+    static_assert(std::is_base_of_v<Protocol, Class> ==
+                      static_cast<bool>(Protocol::Kinds & Class::Kinds),
+                  "a protocol's Kinds must list exactly the classes implementing it");
+    if constexpr (std::is_base_of_v<Protocol, Class>) {
+        return static_cast<Class *>(object);
+    } else {
+        return nullptr;
+    }
+}
+
+template <class T> T *ProtocolCast(Object *object) {
+    switch (object->kind()) {
+    case Object::Kind::String:
+        return Upcast<T, String>(object);
+    case Object::Kind::List:
+        return Upcast<T, List>(object);
+    case Object::Kind::Dictionary:
+        return Upcast<T, Dictionary>(object);
+    case Object::Kind::HashSet:
+        return Upcast<T, HashSet>(object);
+    case Object::Kind::Range:
+        return Upcast<T, Range>(object);
+    case Object::Kind::StringEnumerator:
+        return Upcast<T, StringEnumerator>(object);
+    case Object::Kind::ListEnumerator:
+        return Upcast<T, ListEnumerator>(object);
+    case Object::Kind::DictionaryEnumerator:
+        return Upcast<T, DictionaryEnumerator>(object);
+    case Object::Kind::HashSetEnumerator:
+        return Upcast<T, HashSetEnumerator>(object);
+    case Object::Kind::RangeEnumerator:
+        return Upcast<T, RangeEnumerator>(object);
+    default:
+        return dynamic_cast<T *>(object);
+    }
+}
+
+template Copyable *ProtocolCast(Object *);
+template Enumerable *ProtocolCast(Object *);
+template Enumerator *ProtocolCast(Object *);
+template Subscriptable *ProtocolCast(Object *);
+template NumberCastable *ProtocolCast(Object *);
+
 std::ostream &operator<<(std::ostream &out, const Strong<Object> &object) {
     return out << object->toString();
 }
@@ -19,14 +19,15 @@
 
 #include "sif/runtime/objects/String.h"
 
+#include <cmath>
 #include <format>
 #include <iostream>
 
 SIF_NAMESPACE_BEGIN
 
-Value::Value(const std::string &string) : _value(MakeStrong<String>(string)) {}
-
-Value::Type Value::type() const { return Value::Type(_value.index()); }
+Value::Value(const std::string &string) : _type(Type::Object), _words{} {
+    new (&_object) Strong<Object>(MakeStrong<String>(string));
+}
 
 std::string Value::typeName() const {
     switch (type()) {
@@ -45,95 +46,24 @@ std::string Value::typeName() const {
     return "unknown";
 }
 
-bool Value::isEmpty() const { return type() == Value::Type::Empty; }
-
-bool Value::isNumber() const { return isInteger() || isFloat(); }
-
-bool Value::isBool() const {
-    if (std::holds_alternative<bool>(_value)) {
-        return true;
-    }
-    return false;
-}
-
-bool Value::asBool() const {
-    if (auto v = std::get_if<bool>(&_value)) {
-        return *v;
-    }
-    throw std::runtime_error("expected bool type");
-}
-
-bool Value::isInteger() const {
-    if (std::holds_alternative<Integer>(_value)) {
-        return true;
-    }
-    return false;
-}
-
-Integer Value::asInteger() const {
-    if (auto v = std::get_if<Integer>(&_value)) {
-        return *v;
-    }
-    throw std::runtime_error("expected integer type");
-}
-
-Integer Value::castInteger() const {
-    if (auto v = std::get_if<Integer>(&_value)) {
-        return *v;
-    } else if (auto v = std::get_if<Float>(&_value)) {
-        return static_cast<Integer>(*v);
-    }
-    throw std::runtime_error("can't convert value to number");
-}
-
-bool Value::isFloat() const {
-    if (std::holds_alternative<Float>(_value)) {
-        return true;
-    }
-    return false;
-}
-
-Float Value::asFloat() const {
-    if (auto v = std::get_if<Float>(&_value)) {
-        return *v;
-    }
-    throw std::runtime_error("expected float type");
-}
-
-Float Value::castFloat() const {
-    if (auto v = std::get_if<Float>(&_value)) {
-        return *v;
-    } else if (auto v = std::get_if<Integer>(&_value)) {
-        return static_cast<Float>(*v);
-    }
-    throw std::runtime_error("can't convert value to number");
-}
-
-bool Value::isObject() const {
-    if (std::holds_alternative<Strong<Object>>(_value)) {
-        return true;
-    }
-    return false;
-}
+void Value::TypeError(const char *message) { throw std::runtime_error(message); }
 
 bool Value::isString() const { return isObject() && as<String>() != nullptr; }
 
 Strong<Object> Value::asObject() const {
-    if (auto v = std::get_if<Strong<Object>>(&_value)) {
-        return *v;
+    if (_type != Type::Object) {
+        TypeError("expected object type");
     }
-    throw std::runtime_error("expected object type");
+    return _object;
 }
 
 Strong<Object> &Value::reference() {
-    if (auto v = std::get_if<Strong<Object>>(&_value)) {
-        return *v;
+    if (_type != Type::Object) {
+        TypeError("expected object type");
     }
-    throw std::runtime_error("expected object type");
+    return _object;
 }
 
-std::ostream &operator<<(std::ostream &out, const std::monostate &) { return out << "empty"; }
-
 std::string Value::toString() const {
     if (isObject()) {
         return asObject()->toString();
@@ -142,12 +72,20 @@ std::string Value::toString() const {
 }
 
 std::string Value::description() const {
-    return std::visit(
-        Overload{[](auto &&arg) -> std::string { return std::format("{}", arg); },
-                 [](bool boolValue) -> std::string { return boolValue ? "yes" : "no"; },
-                 [](std::monostate mono) -> std::string { return "empty"; },
-                 [](Strong<Object> object) -> std::string { return object->description(); }},
-        _value);
+    switch (_type) {
+    case Type::Empty:
+        return "empty";
+    case Type::Bool:
+        return _bool ? "yes" : "no";
+    case Type::Integer:
+        return std::format("{}", _integer);
+    case Type::Float:
+        return std::format("{}", _float);
+    case Type::Object:
+        return _object->description();
+    }
+    // Unreachable, but GCC requires a return statement
+    return "unknown";
 }
 
 std::string Value::debugDescription() const {
@@ -175,24 +113,51 @@ bool Value::operator==(const Value &value) const {
     if (type() != value.type() && isNumber() && value.isNumber()) {
         return castFloat() == value.castFloat();
     }
-    return _value == value._value;
+    if (type() != value.type()) {
+        return false;
+    }
+    switch (_type) {
+    case Type::Empty:
+        return true;
+    case Type::Bool:
+        return _bool == value._bool;
+    case Type::Integer:
+        return _integer == value._integer;
+    case Type::Float:
+        return _float == value._float;
+    case Type::Object:
+        return _object == value._object;
+    }
+    return false;
+}
+
+static size_t FloatHash(Float value) {
+    if (std::trunc(value) == value && value >= -0x1p63 && value < 0x1p63) {
+        return static_cast<size_t>(static_cast<Integer>(value));
+    }
+    return std::hash<Float>{}(value);
 }
 
+// Integers hash as themselves. Numbers compare equal as floats, so floats holding an integer hash
+// as that integer, and integers too large to be exact floats hash as the float they compare with.
 size_t Value::Hash::operator()(const Value &value) const {
-    if (value.isEmpty())
+    constexpr Integer exact = Integer(1) << 53;
+    switch (value._type) {
+    case Type::Empty:
         return 0;
-    if (value.isObject()) {
-        if (auto string = value.as<String>(); string && string->string().empty()) {
-            return 0;
+    case Type::Bool:
+        return std::hash<Bool>{}(value._bool);
+    case Type::Integer:
+        if (value._integer >= -exact && value._integer <= exact) {
+            return static_cast<size_t>(value._integer);
         }
-        return value.asObject()->hash();
-    }
-    if (value.isInteger()) {
-        return std::hash<Float>{}(static_cast<Float>(value.asInteger()));
+        return FloatHash(static_cast<Float>(value._integer));
+    case Type::Float:
+        return FloatHash(value._float);
+    case Type::Object:
+        return value._object->hash();
     }
-    size_t hash;
-    std::visit([&](auto arg) { hash = std::hash<decltype(arg)>{}(arg); }, value._value);
-    return hash;
+    return 0;
 }
 
 std::ostream &operator<<(std::ostream &out, const Value &value) { return out << value.toString(); }
@@ -0,0 +1,185 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "sif/runtime/ValueMap.h"
+
+#include <algorithm>
+
+SIF_NAMESPACE_BEGIN
+
+ValueMap::ValueMap(ValueMap &&other) noexcept
+    : _entries(std::move(other._entries)), _index(std::move(other._index)),
+      _size(std::exchange(other._size, 0)) {
+    other._entries.clear();
+    other._index.clear();
+}
+
+ValueMap &ValueMap::operator=(ValueMap &&other) noexcept {
+    _entries = std::move(other._entries);
+    _index = std::move(other._index);
+    _size = std::exchange(other._size, 0);
+    other._entries.clear();
+    other._index.clear();
+    return *this;
+}
+
+size_t ValueMap::HashOf(const Value &key) {
+    // The index only looks at the low bits, so mix the high bits into them.
+    uint64_t hash = Value::Hash()(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash == Erased ? hash - 1 : hash;
+}
+
+void ValueMap::reserve(size_t count) {
+    if (count * 4 > _index.size() * 3) {
+        grow(count);
+    }
+    _entries.reserve(count);
+}
+
+void ValueMap::clear() {
+    _entries.clear();
+    std::fill(_index.begin(), _index.end(), Unused);
+    _size = 0;
+}
+
+size_t ValueMap::probe(const Value &key, size_t hash) const {
+    const size_t mask = _index.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        auto position = _index[slot];
+        if (position == Unused) {
+            return slot;
+        }
+        const auto &entry = _entries[position];
+        if (entry.hash == hash && entry.first == key) {
+            return slot;
+        }
+    }
+}
+
+void ValueMap::grow(size_t count) {
+    if (_size != _entries.size()) {
+        std::erase_if(_entries, [](const Entry &entry) { return entry.hash == Erased; });
+    }
+    size_t capacity = 8;
+    while (capacity * 3 < count * 4) {
+        capacity *= 2;
+    }
+    _index.assign(capacity, Unused);
+    const size_t mask = capacity - 1;
+    for (size_t position = 0; position < _entries.size(); position++) {
+        size_t slot = _entries[position].hash & mask;
+        while (_index[slot] != Unused) {
+            slot = (slot + 1) & mask;
+        }
+        _index[slot] = position;
+    }
+}
+
+std::pair<size_t, bool> ValueMap::locate(const Value &key) {
+    auto hash = HashOf(key);
+    if (!_index.empty()) {
+        auto slot = probe(key, hash);
+        if (_index[slot] != Unused) {
+            return {_index[slot], false};
+        }
+    }
+    if ((_entries.size() + 1) * 4 > _index.size() * 3) {
+        grow(std::max(_size + 1, _size * 2));
+    }
+    auto slot = probe(key, hash);
+    _index[slot] = _entries.size();
+    _entries.push_back({key, Value(), hash});
+    _size++;
+    return {_entries.size() - 1, true};
+}
+
+ValueMap::iterator ValueMap::find(const Value &key) {
+    if (_size == 0) {
+        return end();
+    }
+    auto position = _index[probe(key, HashOf(key))];
+    if (position == Unused) {
+        return end();
+    }
+    return iterator(_entries.data() + position, _entries.data() + _entries.size());
+}
+
+ValueMap::const_iterator ValueMap::find(const Value &key) const {
+    if (_size == 0) {
+        return end();
+    }
+    auto position = _index[probe(key, HashOf(key))];
+    if (position == Unused) {
+        return end();
+    }
+    return const_iterator(_entries.data() + position, _entries.data() + _entries.size());
+}
+
+Value &ValueMap::operator[](const Value &key) { return _entries[locate(key).first].second; }
+
+std::pair<ValueMap::iterator, bool> ValueMap::emplace(const Value &key, const Value &value) {
+    auto [position, inserted] = locate(key);
+    if (inserted) {
+        _entries[position].second = value;
+    }
+    return {iterator(_entries.data() + position, _entries.data() + _entries.size()), inserted};
+}
+
+size_t ValueMap::erase(const Value &key) {
+    if (_size == 0) {
+        return 0;
+    }
+    auto position = _index[probe(key, HashOf(key))];
+    if (position == Unused) {
+        return 0;
+    }
+    // The slot keeps pointing at the erased entry, so that probes for other keys continue past it.
+    auto &entry = _entries[position];
+    entry.first = Value();
+    entry.second = Value();
+    entry.hash = Erased;
+    if (--_size == 0) {
+        clear();
+    }
+    return 1;
+}
+
+ValueMap::const_iterator ValueMap::seek(size_t position) const {
+    auto end = _entries.data() + _entries.size();
+    return const_iterator(_entries.data() + std::min(position, _entries.size()), end);
+}
+
+size_t ValueMap::reservedBytes() const {
+    return _entries.capacity() * sizeof(Entry) + _index.capacity() * sizeof(uint32_t);
+}
+
+bool ValueMap::operator==(const ValueMap &other) const {
+    if (_size != other._size) {
+        return false;
+    }
+    for (const auto &entry : *this) {
+        auto it = other.find(entry.first);
+        if (it == other.end() || !(it->second == entry.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SIF_NAMESPACE_END
@@ -17,6 +17,7 @@
 #include "sif/runtime/VirtualMachine.h"
 #include "sif/runtime/objects/Dictionary.h"
 #include "sif/runtime/objects/Function.h"
+#include "sif/runtime/objects/HashSet.h"
 #include "sif/runtime/objects/List.h"
 #include "sif/runtime/objects/Native.h"
 #include "sif/runtime/objects/Range.h"
@@ -28,38 +29,105 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
-#include <stack>
+#include <utility>
 
 SIF_NAMESPACE_BEGIN
 
-VirtualMachine::VirtualMachine(const VirtualMachineConfig &config) : config(config) {
+VirtualMachine::VirtualMachine(const VirtualMachineConfig &config)
+    : config(config), _heap(new Heap()) {
     _nextGcThreshold = std::max(config.initialGarbageCollectionThresholdBytes,
                                 config.minimumGarbageCollectionThresholdBytes);
+    _nextFullGcThreshold = _nextGcThreshold;
 }
 
 VirtualMachine::~VirtualMachine() {
     _stack.clear();
     _frames.clear();
     _globals.clear();
-    _exports.clear();
+    _links.clear();
     _it = Value();
 
     _gcPending = true;
+    _fullGcRequested = true;
     runPendingGarbageCollection();
+
+    // Containers that outlive the machine, such as a returned value, must not call back into it.
+    for (auto *containers : {_youngContainers, _oldContainers}) {
+        for (auto *object = containers; object;) {
+            object->tracker = nullptr;
+            object->_young = false;
+            object->_previousTracked = nullptr;
+            object = std::exchange(object->_nextTracked, nullptr);
+        }
+    }
+    _youngContainers = nullptr;
+    _oldContainers = nullptr;
+    _trackedContainerCount = 0;
+    _youngContainerCount = 0;
+    _heap->abandon();
 }
 
 void VirtualMachine::addGlobal(const std::string &name, const Value &global) {
-    _globals[name] = global;
+    auto &slot = _globals[globalSlot(name)];
+    slot.global = global;
+    slot.hasGlobal = true;
 }
 
 void VirtualMachine::addGlobals(const Mapping<std::string, Value> &globals) {
     for (const auto &global : globals) {
-        _globals[global.first] = global.second;
+        addGlobal(global.first, global.second);
+    }
+}
+
+Mapping<std::string, Value> VirtualMachine::globals() const {
+    Mapping<std::string, Value> globals;
+    for (const auto &[name, index] : _globalIndices) {
+        if (_globals[index].hasGlobal) {
+            globals[name] = _globals[index].global;
+        }
+    }
+    return globals;
+}
+
+Mapping<std::string, Value> VirtualMachine::exports() const {
+    Mapping<std::string, Value> exports;
+    for (const auto &[name, index] : _globalIndices) {
+        if (_globals[index].hasExport) {
+            exports[name] = _globals[index].exported;
+        }
     }
+    return exports;
+}
+
+uint32_t VirtualMachine::globalSlot(const std::string &name) {
+    auto [it, inserted] = _globalIndices.try_emplace(name, _globals.size());
+    if (inserted) {
+        _globals.emplace_back();
+    }
+    return it->second;
+}
+
+// Slots are allocated on first reference, so names that are only bound later (for example by the
+// REPL adding globals between evaluations) resolve to the slot the binding will eventually fill.
+uint32_t VirtualMachine::resolveGlobal(const Bytecode &bytecode, uint32_t *globalSlots,
+                                      uint16_t index) {
+    auto slot = globalSlot(bytecode.constants()[index].as<String>()->string());
+    globalSlots[index] = slot;
+    return slot;
 }
 
-const Mapping<std::string, Value> &VirtualMachine::globals() const { return _globals; }
-const Mapping<std::string, Value> &VirtualMachine::exports() const { return _exports; }
+// Bytecode is never changed by executing it, so machines on different threads can share it, for
+// example functions exported from a module. Each machine links it once, when a frame first enters
+// it, and keeps the link for as long as the machine lives.
+uint32_t *VirtualMachine::link(const Strong<Bytecode> &bytecode) {
+    auto [it, inserted] = _links.try_emplace(bytecode.get());
+    auto &link = it->second;
+    if (inserted) {
+        link.bytecode = bytecode;
+        link.globalSlots.assign(bytecode->constants().size(), UnresolvedSlot);
+    }
+    return link.globalSlots.data();
+}
 
 CallFrame &VirtualMachine::frame() { return _frames.back(); }
 
@@ -77,6 +145,18 @@ static inline uint16_t ReadJump(Bytecode::Iterator &it) {
     return (high << 8) | low;
 }
 
+template <typename Stack>
+static inline const Value &ReadRegister(uint16_t operand, const Value &popped, const Stack &stack,
+                                        size_t sp, const Bytecode &bytecode) {
+    if (operand < RegisterConstant) {
+        return stack[sp + operand];
+    }
+    if (operand == RegisterStack) {
+        return popped;
+    }
+    return bytecode.constants()[operand - RegisterConstant];
+}
+
 template <typename Stack> static inline typename Stack::value_type Pop(Stack &stack) {
     auto value = std::move(stack.back());
     stack.pop_back();
@@ -87,31 +167,215 @@ static inline const Value &Peek(std::vector<Value> &stack) { return stack.back()
 
 static inline void Push(std::vector<Value> &stack, const Value &value) { stack.push_back(value); }
 
-#define BINARY(OP)                                                                         \
-    auto rhs = Pop(_stack);                                                                \
-    auto lhs = Pop(_stack);                                                                \
-    if (lhs.isInteger() && rhs.isInteger()) {                                              \
-        Push(_stack, lhs.asInteger() OP rhs.asInteger());                                  \
-    } else if (lhs.isNumber() && rhs.isNumber()) {                                         \
-        Push(_stack, lhs.castFloat() OP rhs.castFloat());                                  \
-    } else {                                                                               \
-        error = Error(frame().bytecode->location(frame().ip - 1), Errors::MismatchedTypes, \
-                      lhs.typeName(), #OP, rhs.typeName());                                \
-        break;                                                                             \
+static inline void Truncate(std::vector<Value> &stack, size_t size) {
+    if (stack.size() > size) {
+        stack.erase(stack.begin() + size, stack.end());
+    }
+}
+
+// Use direct threading where the compiler supports labels as values; everything else falls back
+// to a plain switch over the opcode.
+#if defined(__GNUC__) || defined(__clang__)
+#define SIF_THREADED_DISPATCH 1
+#else
+#define SIF_THREADED_DISPATCH 0
+#endif
+
+#if SIF_THREADED_DISPATCH
+#define TARGET(OP) Target_##OP:
+#else
+#define TARGET(OP) case Opcode::OP:
+#endif
+
+// Computed gotos don't run destructors for the scopes they leave, so every opcode body closes its
+// block before dispatching the next instruction.
+#if SIF_THREADED_DISPATCH && !defined(DEBUG)
+#define DISPATCH() goto *dispatchTable[RawValue(*ip++)]
+#else
+#define DISPATCH() goto dispatch
+#endif
+
+// The current frame's ip, sp and bytecode are cached in locals while executing. They are written
+// back before anything that can observe the frame stack and reloaded once the frame stack changes.
+#define SAVE() frame->ip = ip
+
+#define LOAD()                            \
+    do {                                  \
+        frame = &_frames.back();          \
+        ip = frame->ip;                   \
+        sp = frame->sp;                   \
+        bytecode = frame->bytecode.get(); \
+        globalSlots = frame->globalSlots; \
+    } while (0)
+
+#define THROW(...)           \
+    do {                     \
+        error = __VA_ARGS__; \
+        goto unwind;         \
+    } while (0)
+
+// Halt requests and garbage collection are only serviced at safepoints: backward jumps, calls and
+// returns. Every unbounded loop passes through one of these.
+#define SAFEPOINT()                      \
+    do {                                 \
+        if (_haltRequested) {            \
+            goto halt;                   \
+        }                                \
+        maybeTriggerGarbageCollection(); \
+    } while (0)
+
+#define LOCATION() bytecode->location(ip - 1)
+
+#define BINARY(OP)                                                                        \
+    auto rhs = Pop(_stack);                                                               \
+    auto lhs = Pop(_stack);                                                               \
+    if (lhs.isInteger() && rhs.isInteger()) {                                             \
+        Push(_stack, lhs.asInteger() OP rhs.asInteger());                                 \
+    } else if (lhs.isNumber() && rhs.isNumber()) {                                        \
+        Push(_stack, lhs.castFloat() OP rhs.castFloat());                                 \
+    } else {                                                                              \
+        THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), #OP,             \
+                    rhs.typeName()));                                                     \
+    }
+
+// Register operands are read in place. Operands on the stack are popped, right operand first, into
+// temporaries that live until the instruction completes.
+#define REGISTER_OPERANDS()                                                               \
+    auto destination = ReadConstant(ip);                                                  \
+    auto lhsOperand = ReadConstant(ip);                                                   \
+    auto rhsOperand = ReadConstant(ip);                                                   \
+    Value lhsPopped, rhsPopped;                                                           \
+    if (rhsOperand == RegisterStack) {                                                    \
+        rhsPopped = Pop(_stack);                                                          \
+    }                                                                                     \
+    if (lhsOperand == RegisterStack) {                                                    \
+        lhsPopped = Pop(_stack);                                                          \
+    }                                                                                     \
+    const auto &lhs = ReadRegister(lhsOperand, lhsPopped, _stack, sp, *bytecode);         \
+    const auto &rhs = ReadRegister(rhsOperand, rhsPopped, _stack, sp, *bytecode)
+
+#define REGISTER_RESULT(VALUE)                \
+    if (destination == RegisterStack) {       \
+        Push(_stack, VALUE);                  \
+    } else {                                  \
+        _stack[sp + destination] = VALUE;     \
+    }
+
+#define REGISTER_BINARY(OP)                                                               \
+    REGISTER_OPERANDS();                                                                  \
+    if (lhs.isInteger() && rhs.isInteger()) {                                             \
+        REGISTER_RESULT(lhs.asInteger() OP rhs.asInteger());                              \
+    } else if (lhs.isNumber() && rhs.isNumber()) {                                        \
+        REGISTER_RESULT(lhs.castFloat() OP rhs.castFloat());                              \
+    } else {                                                                              \
+        THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), #OP,             \
+                    rhs.typeName()));                                                     \
     }
 
 #if defined(DEBUG)
 std::ostream &operator<<(std::ostream &out, const CallFrame &f) { return out << f.sp; }
 #endif
 
-Result<Value, Error> VirtualMachine::execute(const Strong<Bytecode> &bytecode) {
-    _frames.push_back(CallFrame(bytecode, {}, 0));
-    frame().it = _it;
+Result<Value, Error> VirtualMachine::execute(const Strong<Bytecode> &entry) {
+#if SIF_THREADED_DISPATCH
+    // Indexed by opcode; must match the declaration order of Opcode.
+    static void *const dispatchTable[] = {
+        &&Target_Jump,
+        &&Target_JumpIfFalse,
+        &&Target_JumpIfTrue,
+        &&Target_JumpIfAtEnd,
+        &&Target_Repeat,
+        &&Target_Pop,
+        &&Target_Constant,
+        &&Target_OpenRange,
+        &&Target_ClosedRange,
+        &&Target_List,
+        &&Target_UnpackList,
+        &&Target_Dictionary,
+        &&Target_Set,
+        &&Target_Short,
+        &&Target_Negate,
+        &&Target_Not,
+        &&Target_Increment,
+        &&Target_Add,
+        &&Target_Subtract,
+        &&Target_Multiply,
+        &&Target_Divide,
+        &&Target_Exponent,
+        &&Target_Modulo,
+        &&Target_Equal,
+        &&Target_NotEqual,
+        &&Target_LessThan,
+        &&Target_GreaterThan,
+        &&Target_LessThanOrEqual,
+        &&Target_GreaterThanOrEqual,
+        &&Target_Subscript,
+        &&Target_SetSubscript,
+        &&Target_Enumerate,
+        &&Target_Return,
+        &&Target_True,
+        &&Target_False,
+        &&Target_SetGlobal,
+        &&Target_GetGlobal,
+        &&Target_SetLocal,
+        &&Target_GetLocal,
+        &&Target_SetCapture,
+        &&Target_GetCapture,
+        &&Target_GetEnumerator,
+        &&Target_Show,
+        &&Target_Call,
+        &&Target_Empty,
+        &&Target_GetIt,
+        &&Target_SetIt,
+        &&Target_PushJump,
+        &&Target_PopJump,
+        &&Target_ToString,
+        &&Target_OpenCountedRange,
+        &&Target_ClosedCountedRange,
+        &&Target_JumpIfCountAtEnd,
+        &&Target_NextCount,
+        &&Target_RegisterMove,
+        &&Target_RegisterAdd,
+        &&Target_RegisterSubtract,
+        &&Target_RegisterMultiply,
+        &&Target_RegisterDivide,
+        &&Target_RegisterModulo,
+        &&Target_RegisterEqual,
+        &&Target_RegisterNotEqual,
+        &&Target_RegisterLessThan,
+        &&Target_RegisterGreaterThan,
+        &&Target_RegisterLessThanOrEqual,
+        &&Target_RegisterGreaterThanOrEqual,
+        &&Target_GetLocalGetLocal,
+        &&Target_GetLocalShort,
+        &&Target_JumpIfFalsePop,
+        &&Target_CallSetIt,
+        &&Target_ListReturn,
+        &&Target_EnumerateUnpackList,
+    };
+    static_assert(std::size(dispatchTable) == RawValue(Opcode::EnumerateUnpackList) + 1,
+                  "dispatch table is out of sync with Opcode");
+#endif
+
+    Heap::Scope scope(*_heap);
+    _frames.push_back(CallFrame(entry, {}, 0));
+    _frames.back().globalSlots = link(entry);
+    _frames.back().it = _it;
     Push(_stack, Value());
-    auto localsCount = frame().bytecode->locals().size();
+    auto localsCount = entry->locals().size();
     for (auto i = 0; i < localsCount; i++) {
         Push(_stack, Value());
     }
+
+    CallFrame *frame;
+    Bytecode::Iterator ip;
+    size_t sp;
+    const Bytecode *bytecode;
+    uint32_t *globalSlots;
+    Optional<Error> error;
+    LOAD();
+
+dispatch:
 #if defined(DEBUG)
     if (config.enableTracing) {
         std::cout << "[" << _stack << "]" << std::endl;
@@ -119,489 +383,703 @@ Result<Value, Error> VirtualMachine::execute(const Strong<Bytecode> &bytecode) {
             std::cout << "[" << Join(_frames, ", ") << "]" << std::endl;
         }
         std::cout << std::endl;
+        std::cout << bytecode->decodePosition(ip) << " ";
+        bytecode->disassemble(std::cout, ip);
+        std::cout << std::endl;
     }
 #endif
-    while (true) {
-        Optional<Value> returnValue;
-        Optional<Error> error;
-#if defined(DEBUG)
-        if (config.enableTracing) {
-            std::cout << frame().bytecode->decodePosition(frame().ip) << " ";
-            frame().bytecode->disassemble(std::cout, frame().ip);
-        }
+#if SIF_THREADED_DISPATCH
+    goto *dispatchTable[RawValue(*ip++)];
+#else
+    switch (Read(ip)) {
 #endif
-        switch (Read(frame().ip)) {
-        case Opcode::Return: {
-            auto value = Pop(_stack);
-            while (_stack.size() > frame().sp) {
-                Pop(_stack);
-            }
-            _frames.pop_back();
-            Push(_stack, value);
-            if (_frames.empty()) {
-                returnValue = value;
-            }
-            break;
-        }
-        case Opcode::Jump: {
-            auto offset = ReadJump(frame().ip);
-            frame().ip += offset;
-            break;
-        }
-        case Opcode::JumpIfFalse: {
-            auto offset = ReadJump(frame().ip);
-            auto value = Peek(_stack);
-            if (!value.isBool()) {
-                error =
-                    Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedTrueOrFalse);
-                break;
-            }
-            if (!value.asBool()) {
-                frame().ip += offset;
-            }
-            break;
-        }
-        case Opcode::JumpIfTrue: {
-            auto offset = ReadJump(frame().ip);
-            auto value = Peek(_stack);
-            if (!value.isBool()) {
-                error =
-                    Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedTrueOrFalse);
-                break;
-            }
-            if (value.asBool()) {
-                frame().ip += offset;
-            }
-            break;
-        }
-        case Opcode::JumpIfAtEnd: {
-            auto offset = ReadJump(frame().ip);
-            auto enumerator = Peek(_stack).as<Enumerator>();
-            if (!enumerator) {
-                error =
-                    Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedEnumerator);
-                break;
-            }
-            if (enumerator->isAtEnd()) {
-                frame().ip += offset;
-            }
-            break;
-        }
-        case Opcode::PushJump: {
-            auto location = ReadJump(frame().ip);
-            frame().jumps.push_back(frame().bytecode->code().begin() + location);
-            frame().sps.push_back(_stack.size());
-            frame().error = Value();
-            break;
-        }
-        case Opcode::PopJump: {
-            frame().jumps.pop_back();
-            break;
-        }
-        case Opcode::Repeat: {
-            auto offset = ReadJump(frame().ip);
-            frame().ip -= offset;
-            break;
-        }
-        case Opcode::Pop: {
-            Pop(_stack);
-            break;
-        }
-        case Opcode::Constant: {
-            auto index = ReadConstant(frame().ip);
-            const auto &constant = frame().bytecode->constants()[index];
-            if (auto copyable = constant.as<Copyable>()) {
-                Push(_stack, copyable->copy(*this));
-            } else {
-                Push(_stack, constant);
-            }
-            break;
-        }
-        case Opcode::Short: {
-            Push(_stack, ReadConstant(frame().ip));
-            break;
-        }
-        case Opcode::GetEnumerator: {
-            auto value = Pop(_stack);
-            auto enumerable = value.as<Enumerable>();
-            if (!enumerable) {
-                error = Error(frame().bytecode->location(frame().ip - 1),
-                              Errors::ExpectedListStringDictRange);
-                break;
-            }
-            auto enumeratorValue = enumerable->enumerator(value);
-            Push(_stack, enumeratorValue);
-            if (auto enumerator = enumeratorValue.as<Enumerator>()) {
-                trackContainer(std::static_pointer_cast<Object>(enumerator));
-            }
-            break;
-        }
-        case Opcode::SetGlobal: {
-            auto index = ReadConstant(frame().ip);
-            const auto &name = frame().bytecode->constants()[index];
-            _exports[name.as<String>()->string()] = Pop(_stack);
-            break;
-        }
-        case Opcode::GetGlobal: {
-            auto index = ReadConstant(frame().ip);
-            const auto &nameValue = frame().bytecode->constants()[index];
-            auto name = nameValue.as<String>()->string();
-
-            auto it = _exports.find(name);
-            if (it != _exports.end()) {
-                Push(_stack, it->second);
-                break;
-            }
-            it = _globals.find(name);
-            if (it != _globals.end()) {
-                Push(_stack, it->second);
-                break;
-            }
-            Push(_stack, Value());
-            break;
-        }
-        case Opcode::SetLocal: {
-            auto index = ReadConstant(frame().ip);
-            _stack[frame().sp + index] = Pop(_stack);
-            break;
-        }
-        case Opcode::GetLocal: {
-            auto index = ReadConstant(frame().ip);
-            Push(_stack, _stack[frame().sp + index]);
-            break;
-        }
-        case Opcode::SetCapture: {
-            auto index = ReadConstant(frame().ip);
-            _stack[frame().captures[index]] = Pop(_stack);
-            break;
-        }
-        case Opcode::GetCapture: {
-            auto index = ReadConstant(frame().ip);
-            Push(_stack, _stack[frame().captures[index]]);
-            break;
-        }
-        case Opcode::OpenRange: {
-            auto end = Pop(_stack);
-            auto start = Pop(_stack);
-            if (range(start, end, false)) {
-                break;
-            }
-            break;
+    TARGET(Return) {
+        auto value = Pop(_stack);
+        Truncate(_stack, sp);
+        _frames.pop_back();
+        Push(_stack, value);
+        if (_frames.empty()) {
+            _stack.clear();
+            runPendingGarbageCollection();
+            return own(value);
         }
-        case Opcode::ClosedRange: {
-            auto end = Pop(_stack);
-            auto start = Pop(_stack);
-            if (range(start, end, true)) {
-                break;
-            }
-            break;
+        LOAD();
+    }
+    SAFEPOINT();
+    DISPATCH();
+    TARGET(Jump) {
+        auto offset = ReadJump(ip);
+        ip += offset;
+    }
+    DISPATCH();
+    TARGET(JumpIfFalse) {
+        auto offset = ReadJump(ip);
+        const auto &value = Peek(_stack);
+        if (!value.isBool()) {
+            THROW(Error(LOCATION(), Errors::ExpectedTrueOrFalse));
         }
-        case Opcode::List: {
-            const auto count = ReadConstant(frame().ip);
-            std::vector<Value> values(count);
-            for (size_t i = 0; i < count; i++) {
-                values[count - i - 1] = Pop(_stack);
-            }
-            auto list = make<List>(values);
-            Push(_stack, list);
-            break;
-        }
-        case Opcode::UnpackList: {
-            auto count = ReadConstant(frame().ip);
-            auto value = Pop(_stack);
-            auto list = value.as<List>();
-            if (!list) {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedList,
-                              value.typeName());
-                break;
-            }
-            if (list->size() != count) {
-                error = Error(frame().bytecode->location(frame().ip - 1),
-                              Errors::UnpackListMismatch, count, list->size());
-                break;
-            }
-            for (auto &&value : list->values()) {
-                Push(_stack, value);
-            }
-            break;
-        }
-        case Opcode::Dictionary: {
-            const auto count = ReadConstant(frame().ip);
-            ValueMap values(count);
-            for (size_t i = 0; i < count; i++) {
-                auto value = Pop(_stack);
-                auto key = Pop(_stack);
-                values[key] = value;
-            }
-            auto dictionary = make<Dictionary>(values);
-            Push(_stack, dictionary);
-            break;
-        }
-        case Opcode::Negate: {
-            auto value = Pop(_stack);
-            if (value.isInteger()) {
-                Push(_stack, -value.asInteger());
-            } else if (value.isFloat()) {
-                Push(_stack, -value.asFloat());
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedNumber,
-                              value.typeName());
-                break;
-            }
-            break;
+        if (!value.asBool()) {
+            ip += offset;
         }
-        case Opcode::Not: {
-            auto value = Pop(_stack);
-            if (!value.isBool()) {
-                error =
-                    Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedTrueOrFalse);
-                break;
-            }
-            Push(_stack, !value.asBool());
-            break;
-        }
-        case Opcode::Increment: {
-            auto value = Pop(_stack);
-            Push(_stack, value.asInteger() + 1);
-            break;
-        }
-        case Opcode::Add: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-
-            // Only allow string concatenation between strings
-            if (lhs.isString() && rhs.isString()) {
-                Push(_stack, lhs.toString() + rhs.toString());
-            } else if (lhs.isInteger() && rhs.isInteger()) {
-                Push(_stack, lhs.asInteger() + rhs.asInteger());
-            } else if (lhs.isNumber() && rhs.isNumber()) {
-                Push(_stack, lhs.castFloat() + rhs.castFloat());
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::MismatchedTypes,
-                              lhs.typeName(), "+", rhs.typeName());
+    }
+    DISPATCH();
+    TARGET(JumpIfTrue) {
+        auto offset = ReadJump(ip);
+        const auto &value = Peek(_stack);
+        if (!value.isBool()) {
+            THROW(Error(LOCATION(), Errors::ExpectedTrueOrFalse));
+        }
+        if (value.asBool()) {
+            ip += offset;
+        }
+    }
+    DISPATCH();
+    TARGET(JumpIfAtEnd) {
+        auto offset = ReadJump(ip);
+        auto enumerator = Peek(_stack).as<Enumerator>();
+        if (!enumerator) {
+            THROW(Error(LOCATION(), Errors::ExpectedEnumerator));
+        }
+        if (enumerator->isAtEnd()) {
+            ip += offset;
+        }
+    }
+    DISPATCH();
+    TARGET(PushJump) {
+        auto location = ReadJump(ip);
+        frame->jumps.push_back(bytecode->code().begin() + location);
+        frame->sps.push_back(_stack.size());
+        frame->error = Value();
+    }
+    DISPATCH();
+    TARGET(PopJump) {
+        frame->jumps.pop_back();
+    }
+    DISPATCH();
+    TARGET(Repeat) {
+        auto offset = ReadJump(ip);
+        ip -= offset;
+    }
+    SAFEPOINT();
+    DISPATCH();
+    TARGET(Pop) {
+        _stack.pop_back();
+    }
+    DISPATCH();
+    TARGET(Constant) {
+        auto index = ReadConstant(ip);
+        const auto &constant = bytecode->constants()[index];
+        if (constant.isLiteral()) {
+            Push(_stack, constant);
+        } else if (auto copyable = constant.as<Copyable>()) {
+            Push(_stack, copyable->copy(*this));
+        } else {
+            Push(_stack, constant);
+        }
+    }
+    DISPATCH();
+    TARGET(Short) {
+        Push(_stack, ReadConstant(ip));
+    }
+    DISPATCH();
+    TARGET(GetEnumerator) {
+        auto value = Pop(_stack);
+        auto enumerable = value.as<Enumerable>();
+        if (!enumerable) {
+            THROW(Error(LOCATION(), Errors::ExpectedListStringDictRange));
+        }
+        auto enumeratorValue = enumerable->enumerator(value);
+        Push(_stack, enumeratorValue);
+        if (auto enumerator = enumeratorValue.as<TrackedObject>()) {
+            trackContainer(enumerator.get());
+        }
+    }
+    DISPATCH();
+    TARGET(SetGlobal) {
+        auto index = ReadConstant(ip);
+        auto slot = globalSlots[index];
+        if (slot == UnresolvedSlot) {
+            slot = resolveGlobal(*bytecode, globalSlots, index);
+        }
+        auto &global = _globals[slot];
+        global.exported = own(Pop(_stack));
+        global.hasExport = true;
+    }
+    DISPATCH();
+    TARGET(GetGlobal) {
+        auto index = ReadConstant(ip);
+        auto slot = globalSlots[index];
+        if (slot == UnresolvedSlot) {
+            slot = resolveGlobal(*bytecode, globalSlots, index);
+        }
+        const auto &global = _globals[slot];
+        Push(_stack, global.hasExport ? global.exported : global.global);
+    }
+    DISPATCH();
+    TARGET(SetLocal) {
+        auto index = ReadConstant(ip);
+        _stack[sp + index] = own(Pop(_stack));
+    }
+    DISPATCH();
+    TARGET(GetLocal) {
+        auto index = ReadConstant(ip);
+        Push(_stack, _stack[sp + index]);
+    }
+    DISPATCH();
+    TARGET(SetCapture) {
+        auto index = ReadConstant(ip);
+        _stack[frame->captures[index]] = own(Pop(_stack));
+    }
+    DISPATCH();
+    TARGET(GetCapture) {
+        auto index = ReadConstant(ip);
+        Push(_stack, _stack[frame->captures[index]]);
+    }
+    DISPATCH();
+    TARGET(OpenRange) {
+        auto end = Pop(_stack);
+        auto start = Pop(_stack);
+        SAVE();
+        if (auto rangeError = range(start, end, false)) {
+            THROW(rangeError.value());
+        }
+    }
+    DISPATCH();
+    TARGET(ClosedRange) {
+        auto end = Pop(_stack);
+        auto start = Pop(_stack);
+        SAVE();
+        if (auto rangeError = range(start, end, true)) {
+            THROW(rangeError.value());
+        }
+    }
+    DISPATCH();
+    TARGET(List) {
+        const auto count = ReadConstant(ip);
+        const auto first = _stack.end() - count;
+        for (auto it = first; it != _stack.end(); it++) {
+            *it = own(*it);
+        }
+        auto list = make<List>(first, _stack.end());
+        Truncate(_stack, _stack.size() - count);
+        Push(_stack, list);
+    }
+    DISPATCH();
+    TARGET(UnpackList) {
+        auto count = ReadConstant(ip);
+        auto value = Pop(_stack);
+        auto list = value.as<List>();
+        if (!list) {
+            THROW(Error(LOCATION(), Errors::ExpectedList, value.typeName()));
+        }
+        if (list->size() != count) {
+            THROW(Error(LOCATION(), Errors::UnpackListMismatch, count, list->size()));
+        }
+        for (size_t i = 0; i < count; i++) {
+            Push(_stack, list->at(i));
+        }
+    }
+    DISPATCH();
+    TARGET(Dictionary) {
+        const auto count = ReadConstant(ip);
+        ValueMap values;
+        values.reserve(count);
+        // Insert the pairs in the order they were written, which is the order they enumerate in.
+        for (auto it = _stack.end() - 2 * count; it != _stack.end(); it += 2) {
+            values[own(it[0])] = own(it[1]);
+        }
+        Truncate(_stack, _stack.size() - 2 * count);
+        auto dictionary = make<Dictionary>(std::move(values));
+        Push(_stack, dictionary);
+    }
+    DISPATCH();
+    TARGET(Set) {
+        const auto count = ReadConstant(ip);
+        const auto first = _stack.end() - count;
+        for (auto it = first; it != _stack.end(); it++) {
+            *it = own(*it);
+        }
+        auto set = make<HashSet>(first, _stack.end());
+        Truncate(_stack, _stack.size() - count);
+        Push(_stack, set);
+    }
+    DISPATCH();
+    TARGET(Negate) {
+        auto value = Pop(_stack);
+        if (value.isInteger()) {
+            Push(_stack, -value.asInteger());
+        } else if (value.isFloat()) {
+            Push(_stack, -value.asFloat());
+        } else {
+            THROW(Error(LOCATION(), Errors::ExpectedNumber, value.typeName()));
+        }
+    }
+    DISPATCH();
+    TARGET(Not) {
+        auto value = Pop(_stack);
+        if (!value.isBool()) {
+            THROW(Error(LOCATION(), Errors::ExpectedTrueOrFalse));
+        }
+        Push(_stack, !value.asBool());
+    }
+    DISPATCH();
+    TARGET(Increment) {
+        auto value = Pop(_stack);
+        Push(_stack, value.asInteger() + 1);
+    }
+    DISPATCH();
+    TARGET(Add) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+
+        // Only allow string concatenation between strings
+        if (lhs.isString() && rhs.isString()) {
+            Push(_stack, lhs.toString() + rhs.toString());
+        } else if (lhs.isInteger() && rhs.isInteger()) {
+            Push(_stack, lhs.asInteger() + rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            Push(_stack, lhs.castFloat() + rhs.castFloat());
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "+", rhs.typeName()));
+        }
+    }
+    DISPATCH();
+    TARGET(Subtract) {
+        BINARY(-);
+    }
+    DISPATCH();
+    TARGET(Multiply) {
+        BINARY(*);
+    }
+    DISPATCH();
+    TARGET(Divide) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        if (lhs.isInteger() && rhs.isInteger()) {
+            if (rhs.asInteger() == 0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
             }
-            break;
-        }
-        case Opcode::Subtract: {
-            BINARY(-);
-            break;
-        }
-        case Opcode::Multiply: {
-            BINARY(*);
-            break;
-        }
-        case Opcode::Divide: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            if (lhs.isInteger() && rhs.isInteger()) {
-                if (rhs.asInteger() == 0) {
-                    error = Error(frame().bytecode->location(frame().ip - 1), Errors::DivideByZero);
-                    break;
-                }
-                Push(_stack, lhs.asInteger() / rhs.asInteger());
-            } else if (lhs.isNumber() && rhs.isNumber()) {
-                float denom = rhs.castFloat();
-                if (denom == 0.0) {
-                    error = Error(frame().bytecode->location(frame().ip - 1), Errors::DivideByZero);
-                    break;
-                }
-                Push(_stack, lhs.castFloat() / denom);
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::MismatchedTypes,
-                              lhs.typeName(), "/", rhs.typeName());
-                break;
+            Push(_stack, lhs.asInteger() / rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            float denom = rhs.castFloat();
+            if (denom == 0.0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
             }
-            break;
+            Push(_stack, lhs.castFloat() / denom);
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "/", rhs.typeName()));
         }
-        case Opcode::Exponent: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            if (lhs.isNumber() && rhs.isNumber()) {
-                Push(_stack, std::pow(lhs.castFloat(), rhs.castFloat()));
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::MismatchedTypes,
-                              lhs.typeName(), "^", rhs.typeName());
-                break;
-            }
-            break;
-        }
-        case Opcode::Modulo: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            if (lhs.isInteger() && rhs.isInteger()) {
-                if (rhs.asInteger() == 0) {
-                    error = Error(frame().bytecode->location(frame().ip - 1), Errors::DivideByZero);
-                    break;
-                }
-                Push(_stack, lhs.asInteger() % rhs.asInteger());
-            } else if (lhs.isNumber() && rhs.isNumber()) {
-                Float denom = rhs.castFloat();
-                if (denom == 0.0) {
-                    error = Error(frame().bytecode->location(frame().ip - 1), Errors::DivideByZero);
-                    break;
-                }
-                Push(_stack, std::fmod(lhs.castFloat(), denom));
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1), Errors::MismatchedTypes,
-                              lhs.typeName(), "%", rhs.typeName());
-                break;
+    }
+    DISPATCH();
+    TARGET(Exponent) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        if (lhs.isNumber() && rhs.isNumber()) {
+            Push(_stack, std::pow(lhs.castFloat(), rhs.castFloat()));
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "^", rhs.typeName()));
+        }
+    }
+    DISPATCH();
+    TARGET(Modulo) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        if (lhs.isInteger() && rhs.isInteger()) {
+            if (rhs.asInteger() == 0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
             }
-            break;
-        }
-        case Opcode::Equal: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            Push(_stack, lhs == rhs);
-            break;
-        }
-        case Opcode::NotEqual: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            Push(_stack, !(lhs == rhs));
-            break;
-        }
-        case Opcode::LessThan: {
-            BINARY(<);
-            break;
-        }
-        case Opcode::GreaterThan: {
-            BINARY(>);
-            break;
-        }
-        case Opcode::LessThanOrEqual: {
-            BINARY(<=);
-            break;
-        }
-        case Opcode::GreaterThanOrEqual: {
-            BINARY(>=);
-            break;
-        }
-        case Opcode::Subscript: {
-            auto rhs = Pop(_stack);
-            auto lhs = Pop(_stack);
-            if (auto subscriptable = lhs.as<Subscriptable>()) {
-                if (auto result = subscriptable->subscript(
-                        *this, frame().bytecode->location(frame().ip - 1), rhs)) {
-                    Push(_stack, result.value());
-                } else {
-                    error = result.error();
-                    break;
-                }
-            } else {
-                error = Error(frame().bytecode->location(frame().ip - 1),
-                              Errors::ExpectedListStringDictRange);
-                break;
+            Push(_stack, lhs.asInteger() % rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            Float denom = rhs.castFloat();
+            if (denom == 0.0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
             }
-            break;
-        }
-        case Opcode::SetSubscript: {
-            auto subscript = Pop(_stack);
-            auto target = Pop(_stack);
-            auto value = Pop(_stack);
-            if (auto subscriptable = target.as<Subscriptable>()) {
-                auto result = subscriptable->setSubscript(
-                    *this, frame().bytecode->location(frame().ip - 1), subscript, value);
-                if (!result) {
-                    error = result.error();
-                    break;
-                }
+            Push(_stack, std::fmod(lhs.castFloat(), denom));
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "%", rhs.typeName()));
+        }
+    }
+    DISPATCH();
+    TARGET(Equal) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        Push(_stack, lhs == rhs);
+    }
+    DISPATCH();
+    TARGET(NotEqual) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        Push(_stack, !(lhs == rhs));
+    }
+    DISPATCH();
+    TARGET(LessThan) {
+        BINARY(<);
+    }
+    DISPATCH();
+    TARGET(GreaterThan) {
+        BINARY(>);
+    }
+    DISPATCH();
+    TARGET(LessThanOrEqual) {
+        BINARY(<=);
+    }
+    DISPATCH();
+    TARGET(GreaterThanOrEqual) {
+        BINARY(>=);
+    }
+    DISPATCH();
+    TARGET(Subscript) {
+        auto rhs = Pop(_stack);
+        auto lhs = Pop(_stack);
+        auto subscriptable = lhs.as<Subscriptable>();
+        if (!subscriptable) {
+            THROW(Error(LOCATION(), Errors::ExpectedListStringDictRange));
+        }
+        auto result = subscriptable->subscript(*this, LOCATION(), rhs);
+        if (!result) {
+            THROW(result.error());
+        }
+        Push(_stack, result.value());
+    }
+    DISPATCH();
+    TARGET(SetSubscript) {
+        auto subscript = Pop(_stack);
+        auto target = Pop(_stack);
+        auto value = own(Pop(_stack));
+        auto subscriptable = target.as<Subscriptable>();
+        if (!subscriptable) {
+            THROW(Error(LOCATION(), Errors::ExpectedListStringDictRange));
+        }
+        auto result = subscriptable->setSubscript(*this, LOCATION(), subscript, value);
+        if (!result) {
+            THROW(result.error());
+        }
+    }
+    DISPATCH();
+    TARGET(Enumerate) {
+        const auto &value = Peek(_stack);
+        Push(_stack, value.as<Enumerator>()->enumerate());
+    }
+    DISPATCH();
+    TARGET(True) {
+        Push(_stack, true);
+    }
+    DISPATCH();
+    TARGET(False) {
+        Push(_stack, false);
+    }
+    DISPATCH();
+    TARGET(Call) {
+        auto callLocation = ip - bytecode->code().begin() - 1;
+        auto count = ReadConstant(ip);
+        SAVE();
+        auto callError = call(_stack.end()[-count - 1], count, callLocation);
+        LOAD();
+        if (callError) {
+            THROW(callError.value());
+        }
+    }
+    SAFEPOINT();
+    DISPATCH();
+    TARGET(Empty) {
+        Push(_stack, Value());
+    }
+    DISPATCH();
+    TARGET(SetIt) {
+        frame->it = own(Pop(_stack));
+    }
+    DISPATCH();
+    TARGET(GetIt) {
+        Push(_stack, frame->it);
+    }
+    DISPATCH();
+    TARGET(Show) {
+        std::cout << Peek(_stack) << std::endl;
+    }
+    DISPATCH();
+    TARGET(ToString) {
+        auto value = Pop(_stack);
+        Push(_stack, value.toString());
+    }
+    DISPATCH();
+    TARGET(OpenCountedRange)
+    TARGET(ClosedCountedRange) {
+        // Leaves the first and last values of a counted loop on the stack. Neither bound needs a
+        // value past it, which may not be representable: the first value is empty if the range
+        // is, and NextCount empties the counter once it has pushed the last value.
+        auto closed = ip[-1] == Opcode::ClosedCountedRange;
+        auto &start = _stack.end()[-2];
+        auto &end = _stack.end()[-1];
+        if (!start.isInteger() || !end.isInteger()) {
+            THROW(Error(LOCATION(), Errors::ExpectedInteger));
+        }
+        if (end.asInteger() < start.asInteger()) {
+            THROW(Error(LOCATION(), Errors::BoundsMismatch));
+        }
+        if (!closed) {
+            if (end.asInteger() == start.asInteger()) {
+                start = Value();
             } else {
-                error = Error(frame().bytecode->location(frame().ip - 1),
-                              Errors::ExpectedListStringDictRange);
-                break;
+                end = end.asInteger() - 1;
             }
-            break;
-        }
-        case Opcode::Enumerate: {
-            auto value = Peek(_stack);
-            Push(_stack, value.as<Enumerator>()->enumerate());
-            break;
-        }
-        case Opcode::True: {
-            Push(_stack, true);
-            break;
-        }
-        case Opcode::False: {
-            Push(_stack, false);
-            break;
-        }
-        case Opcode::Call: {
-            auto callLocation = frame().ip - frame().bytecode->code().begin() - 1;
-            auto count = ReadConstant(frame().ip);
-            auto object = _stack.end()[-count - 1];
-            auto ranges = frame().bytecode->argumentRanges(callLocation);
-            error = call(object, count, ranges);
-            break;
-        }
-        case Opcode::Empty: {
-            Push(_stack, Value());
-            break;
         }
-        case Opcode::SetIt: {
-            frame().it = Pop(_stack);
-            break;
+    }
+    DISPATCH();
+    TARGET(JumpIfCountAtEnd) {
+        auto offset = ReadJump(ip);
+        if (!_stack.end()[-2].isInteger()) {
+            ip += offset;
         }
-        case Opcode::GetIt: {
-            Push(_stack, frame().it);
-            break;
+    }
+    DISPATCH();
+    TARGET(NextCount) {
+        auto &counter = _stack.end()[-2];
+        auto value = counter.asInteger();
+        if (value == _stack.end()[-1].asInteger()) {
+            counter = Value();
+        } else {
+            counter = value + 1;
         }
-        case Opcode::Show: {
-            std::cout << Peek(_stack) << std::endl;
-            break;
+        Push(_stack, value);
+    }
+    DISPATCH();
+    TARGET(RegisterMove) {
+        auto destination = ReadConstant(ip);
+        auto source = ReadConstant(ip);
+        if (source == RegisterStack) {
+            _stack[sp + destination] = Pop(_stack);
+        } else {
+            _stack[sp + destination] = ReadRegister(source, Value(), _stack, sp, *bytecode);
         }
-        case Opcode::ToString: {
-            auto value = Pop(_stack);
-            Push(_stack, value.toString());
-            break;
+    }
+    DISPATCH();
+    TARGET(RegisterAdd) {
+        REGISTER_OPERANDS();
+        if (lhs.isString() && rhs.isString()) {
+            REGISTER_RESULT(lhs.toString() + rhs.toString());
+        } else if (lhs.isInteger() && rhs.isInteger()) {
+            REGISTER_RESULT(lhs.asInteger() + rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            REGISTER_RESULT(lhs.castFloat() + rhs.castFloat());
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "+", rhs.typeName()));
         }
+    }
+    DISPATCH();
+    TARGET(RegisterSubtract) {
+        REGISTER_BINARY(-);
+    }
+    DISPATCH();
+    TARGET(RegisterMultiply) {
+        REGISTER_BINARY(*);
+    }
+    DISPATCH();
+    TARGET(RegisterDivide) {
+        REGISTER_OPERANDS();
+        if (lhs.isInteger() && rhs.isInteger()) {
+            if (rhs.asInteger() == 0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
+            }
+            REGISTER_RESULT(lhs.asInteger() / rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            float denom = rhs.castFloat();
+            if (denom == 0.0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
+            }
+            REGISTER_RESULT(lhs.castFloat() / denom);
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "/", rhs.typeName()));
         }
-#if defined(DEBUG)
-        if (config.enableTracing) {
-            std::cout << std::endl << "[" << _stack << "]" << std::endl;
-            if (_frames.size() > 1) {
-                std::cout << "[" << Join(_frames, ", ") << "]" << std::endl;
+    }
+    DISPATCH();
+    TARGET(RegisterModulo) {
+        REGISTER_OPERANDS();
+        if (lhs.isInteger() && rhs.isInteger()) {
+            if (rhs.asInteger() == 0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
+            }
+            REGISTER_RESULT(lhs.asInteger() % rhs.asInteger());
+        } else if (lhs.isNumber() && rhs.isNumber()) {
+            Float denom = rhs.castFloat();
+            if (denom == 0.0) {
+                THROW(Error(LOCATION(), Errors::DivideByZero));
             }
-            std::cout << std::endl;
+            REGISTER_RESULT(std::fmod(lhs.castFloat(), denom));
+        } else {
+            THROW(Error(LOCATION(), Errors::MismatchedTypes, lhs.typeName(), "%", rhs.typeName()));
         }
-#endif
-        if (_haltRequested) {
-            error = Error(frame().bytecode->location(frame().ip), Errors::ProgramHalted);
-            runPendingGarbageCollection();
-            return Fail(error.value());
+    }
+    DISPATCH();
+    TARGET(RegisterEqual) {
+        REGISTER_OPERANDS();
+        REGISTER_RESULT(lhs == rhs);
+    }
+    DISPATCH();
+    TARGET(RegisterNotEqual) {
+        REGISTER_OPERANDS();
+        REGISTER_RESULT(!(lhs == rhs));
+    }
+    DISPATCH();
+    TARGET(RegisterLessThan) {
+        REGISTER_BINARY(<);
+    }
+    DISPATCH();
+    TARGET(RegisterGreaterThan) {
+        REGISTER_BINARY(>);
+    }
+    DISPATCH();
+    TARGET(RegisterLessThanOrEqual) {
+        REGISTER_BINARY(<=);
+    }
+    DISPATCH();
+    TARGET(RegisterGreaterThanOrEqual) {
+        REGISTER_BINARY(>=);
+    }
+    DISPATCH();
+    TARGET(GetLocalGetLocal) {
+        auto first = ReadConstant(ip);
+        ip++;
+        auto second = ReadConstant(ip);
+        Push(_stack, _stack[sp + first]);
+        Push(_stack, _stack[sp + second]);
+    }
+    DISPATCH();
+    TARGET(GetLocalShort) {
+        auto index = ReadConstant(ip);
+        ip++;
+        auto value = ReadConstant(ip);
+        Push(_stack, _stack[sp + index]);
+        Push(_stack, value);
+    }
+    DISPATCH();
+    TARGET(JumpIfFalsePop) {
+        auto offset = ReadJump(ip);
+        const auto &value = Peek(_stack);
+        if (!value.isBool()) {
+            THROW(Error(LOCATION(), Errors::ExpectedTrueOrFalse));
+        }
+        if (!value.asBool()) {
+            ip += offset;
+        } else {
+            _stack.pop_back();
+            ip++;
         }
-        if (error.has_value()) {
-            if (frame().sps.size() > 0) {
-                auto sp = Pop(frame().sps);
-                while (_stack.size() > sp) {
-                    Pop(_stack);
-                }
-            }
-            while (_frames.size() > 1 && frame().jumps.size() == 0) {
-                while (_stack.size() > frame().sp) {
-                    Pop(_stack);
+    }
+    DISPATCH();
+    TARGET(CallSetIt) {
+        auto callLocation = ip - bytecode->code().begin() - 1;
+        auto count = ReadConstant(ip);
+        auto depth = _frames.size();
+        SAVE();
+        auto callError = call(_stack.end()[-count - 1], count, callLocation);
+        LOAD();
+        if (callError) {
+            THROW(callError.value());
+        }
+        // Natives complete immediately, so their result can be stored right away. Functions return
+        // to the SetIt that follows this instruction.
+        if (_frames.size() == depth) {
+            frame->it = own(Pop(_stack));
+            ip++;
+        }
+    }
+    SAFEPOINT();
+    DISPATCH();
+    TARGET(ListReturn) {
+        // A caller that unpacks the returned list straight away is handed its values on the stack
+        // instead, and skips its UnpackList. Otherwise the list is built and the Return that
+        // follows this instruction runs as usual.
+        const auto count = ReadConstant(ip);
+        if (_frames.size() > 1) {
+            auto callerIp = _frames.end()[-2].ip;
+            if (*callerIp == Opcode::UnpackList && ReadConstant(++callerIp) == count) {
+                const auto first = _stack.end() - count;
+                for (size_t i = 0; i < count; i++) {
+                    _stack[sp + i] = own(std::move(first[i]));
                 }
+                Truncate(_stack, sp + count);
                 _frames.pop_back();
+                _frames.back().ip = callerIp;
+                LOAD();
+                SAFEPOINT();
+                DISPATCH();
             }
-            if (frame().jumps.size() == 0) {
-                runPendingGarbageCollection();
-                return Fail(error.value());
-            }
-            frame().error = error.value().value;
-            frame().ip = Pop(frame().jumps);
         }
-        if (returnValue.has_value()) {
-            _stack.clear();
-            runPendingGarbageCollection();
-            return returnValue.value();
+        const auto first = _stack.end() - count;
+        for (auto it = first; it != _stack.end(); it++) {
+            *it = own(*it);
+        }
+        auto list = make<List>(first, _stack.end());
+        Truncate(_stack, _stack.size() - count);
+        Push(_stack, list);
+    }
+    DISPATCH();
+    TARGET(EnumerateUnpackList) {
+        // Dictionary entries unpacked into a key and a value are pushed without building a list
+        // for each entry. Anything else enumerates as usual and runs the UnpackList that follows.
+        auto next = ip + 1;
+        const auto count = ReadConstant(next);
+        const auto &enumerator = Peek(_stack);
+        if (auto entries = enumerator.as<DictionaryEnumerator>(); entries && count == 2) {
+            Value key, value;
+            entries->enumerateEntry(key, value);
+            Push(_stack, key);
+            Push(_stack, value);
+            ip = next;
+        } else {
+            Push(_stack, enumerator.as<Enumerator>()->enumerate());
         }
+    }
+    DISPATCH();
+#if !SIF_THREADED_DISPATCH
+    }
+    goto dispatch;
+#endif
+
+halt:
+    error = Error(bytecode->location(ip), Errors::ProgramHalted);
+    runPendingGarbageCollection();
+    return Fail(error.value());
 
-        maybeTriggerGarbageCollection();
+unwind:
+    if (_haltRequested) {
+        goto halt;
+    }
+    if (frame->sps.size() > 0) {
+        Truncate(_stack, Pop(frame->sps));
+    }
+    while (_frames.size() > 1 && _frames.back().jumps.size() == 0) {
+        Truncate(_stack, _frames.back().sp);
+        _frames.pop_back();
     }
+    frame = &_frames.back();
+    if (frame->jumps.size() == 0) {
+        runPendingGarbageCollection();
+        return Fail(error.value());
+    }
+    frame->error = own(error.value().value);
+    frame->ip = Pop(frame->jumps);
+    LOAD();
+    SAFEPOINT();
+    goto dispatch;
 }
 
+#undef REGISTER_BINARY
+#undef REGISTER_RESULT
+#undef REGISTER_OPERANDS
+#undef BINARY
+#undef LOCATION
+#undef SAFEPOINT
+#undef THROW
+#undef LOAD
+#undef SAVE
+#undef DISPATCH
+#undef TARGET
+
 void VirtualMachine::requestHalt() { _haltRequested = true; }
 
-Optional<Error> VirtualMachine::call(Value object, int count, std::vector<SourceRange> ranges) {
+// The callee is referenced in place on the stack, so it must not be used once the stack changes.
+Optional<Error> VirtualMachine::call(const Value &object, int count, size_t callLocation) {
     if (auto fn = object.as<Function>()) {
         std::vector<size_t> captures;
         for (auto capture : fn->captures()) {
@@ -612,7 +1090,11 @@ Optional<Error> VirtualMachine::call(Value object, int count, std::vector<Source
             }
         }
         auto sp = _stack.size() - count - 1;
+        for (auto i = sp + 1; i < _stack.size(); i++) {
+            _stack[i] = own(std::move(_stack[i]));
+        }
         _frames.push_back(CallFrame(fn->bytecode(), captures, sp));
+        frame().globalSlots = link(fn->bytecode());
 
         auto additionalLocalsCount = frame().bytecode->locals().size() - count;
         for (auto i = 0; i < additionalLocalsCount; i++) {
@@ -622,7 +1104,7 @@ Optional<Error> VirtualMachine::call(Value object, int count, std::vector<Source
         auto location = frame().bytecode->location(frame().ip - 3);
         auto args = &_stack.end()[-count];
 
-        NativeCallContext context(*this, location, args, ranges);
+        NativeCallContext context(*this, location, args, frame().bytecode.get(), callLocation);
 
         auto previousInNative = _inNativeCall;
         auto startIndex = _transientRoots.size();
@@ -650,6 +1132,13 @@ Optional<Error> VirtualMachine::call(Value object, int count, std::vector<Source
     return None;
 }
 
+Value VirtualMachine::own(Value value) {
+    if (value.isLiteral()) {
+        return value.as<Copyable>()->copy(*this);
+    }
+    return value;
+}
+
 Optional<Error> VirtualMachine::range(Value start, Value end, bool closed) {
     if (!start.isInteger()) {
         return Error(frame().bytecode->location(frame().ip - 1), Errors::ExpectedInteger);
@@ -666,132 +1155,176 @@ Optional<Error> VirtualMachine::range(Value start, Value end, bool closed) {
 
 #pragma mark - Garbage Collection
 
-std::vector<Strong<Object>> VirtualMachine::gatherRootObjects() const {
-    std::vector<Strong<Object>> roots;
-
-    // Add objects from globals
-    for (const auto &pair : _globals) {
-        if (pair.second.isObject()) {
-            roots.push_back(pair.second.asObject());
-        }
+void GarbageCollectionStatistics::record(const Collection &collection) {
+    if (collection.full) {
+        fullCollections++;
+    } else {
+        youngCollections++;
+    }
+    totalPause += collection.pause;
+    maximumPause = std::max(maximumPause, collection.pause);
+    objectsMarked += collection.objectsMarked;
+    objectsFreed += collection.objectsFreed;
+    bytesReclaimed += collection.bytesReclaimed;
+    auto microseconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(collection.pause).count();
+    size_t bucket = 0;
+    while (bucket + 1 < PauseBuckets && microseconds >= (int64_t(1) << bucket)) {
+        bucket++;
     }
+    pauseHistogram[bucket]++;
+    lastCollection = collection;
+}
 
-    // Add objects from exports
-    for (const auto &pair : _exports) {
-        if (pair.second.isObject()) {
-            roots.push_back(pair.second.asObject());
+void VirtualMachine::traceRoots(Tracer &tracer) {
+    // Globals and exports
+    for (auto &slot : _globals) {
+        if (slot.global.isObject()) {
+            tracer.visit(slot.global.reference());
+        }
+        if (slot.exported.isObject()) {
+            tracer.visit(slot.exported.reference());
         }
     }
 
-    // Add objects from the VM stack
-    for (const auto &value : _stack) {
+    // The VM stack
+    for (auto &value : _stack) {
         if (value.isObject()) {
-            roots.push_back(value.asObject());
+            tracer.visit(value.reference());
         }
     }
 
-    // Add objects from the "it" variable
+    // The "it" variable
     if (_it.isObject()) {
-        roots.push_back(_it.asObject());
+        tracer.visit(_it.reference());
     }
 
-    // Add objects from call frames
-    for (const auto &frame : _frames) {
+    // Call frames
+    for (auto &frame : _frames) {
         if (frame.error.isObject()) {
-            roots.push_back(frame.error.asObject());
+            tracer.visit(frame.error.reference());
         }
         if (frame.it.isObject()) {
-            roots.push_back(frame.it.asObject());
+            tracer.visit(frame.it.reference());
         }
     }
 
-    for (const auto &weak : _transientRoots) {
-        if (auto object = weak.lock()) {
-            roots.push_back(std::move(object));
-        }
+    for (auto &object : _transientRoots) {
+        tracer.visit(object);
     }
-
-    return roots;
 }
 
 void VirtualMachine::notifyContainerMutation(List *list) {
     assert(list && "notifyContainerMutation called with null List");
+    rememberContainer(list);
     accountForContainer(list, estimateContainerSize(list), true);
     maybeTriggerGarbageCollection();
 }
 
 void VirtualMachine::notifyContainerMutation(Dictionary *dictionary) {
     assert(dictionary && "notifyContainerMutation called with null Dictionary");
+    rememberContainer(dictionary);
     accountForContainer(dictionary, estimateContainerSize(dictionary), true);
     maybeTriggerGarbageCollection();
 }
 
+void VirtualMachine::notifyContainerMutation(HashSet *set) {
+    assert(set && "notifyContainerMutation called with null HashSet");
+    rememberContainer(set);
+    accountForContainer(set, estimateContainerSize(set), true);
+    maybeTriggerGarbageCollection();
+}
+
 void VirtualMachine::serviceGarbageCollection() {
     if (_gcInProgress) {
         return;
     }
     _gcPending = true;
+    _fullGcRequested = true;
     runPendingGarbageCollection();
 }
 
-void VirtualMachine::trackContainer(const Strong<Object> &container) {
-    auto *object = container.get();
-    if (_trackedContainers.find(object) != _trackedContainers.end()) {
+void VirtualMachine::trackContainer(TrackedObject *object) {
+    if (object->tracker) {
         return;
     }
-    _trackedContainers[object] = container;
+    object->tracker = this;
+    linkContainer(object, true);
+    _trackedContainerCount++;
     accountForContainer(object, estimateContainerSize(object), true);
     maybeTriggerGarbageCollection();
 }
 
-size_t VirtualMachine::estimateContainerSize(const Object *object) const {
-    if (auto list = dynamic_cast<const List *>(object)) {
-        const auto &values = list->values();
-        return sizeof(List) + values.capacity() * sizeof(Value);
+size_t VirtualMachine::estimateContainerSize(const TrackedObject *object) const {
+    if (object->kind() == Object::Kind::List) {
+        return sizeof(List) + static_cast<const List *>(object)->reservedBytes();
+    }
+    if (object->kind() == Object::Kind::Dictionary) {
+        return sizeof(Dictionary) + static_cast<const Dictionary *>(object)->reservedBytes();
     }
-    if (auto dictionary = dynamic_cast<const Dictionary *>(object)) {
-        const auto &values = dictionary->values();
-        size_t elementBytes = values.size() * sizeof(ValueMap::value_type);
-        size_t bucketBytes = values.bucket_count() * sizeof(void *);
-        return sizeof(Dictionary) + elementBytes + bucketBytes;
+    if (object->kind() == Object::Kind::HashSet) {
+        return sizeof(HashSet) + static_cast<const HashSet *>(object)->elements().reservedBytes();
     }
     return 0;
 }
 
-void VirtualMachine::cleanupExpiredContainers() {
-    std::vector<Object *> expired;
-    expired.reserve(_trackedContainers.size());
-    for (auto &entry : _trackedContainers) {
-        if (entry.second.expired()) {
-            expired.push_back(entry.first);
-        }
+void VirtualMachine::linkContainer(TrackedObject *object, bool young) {
+    auto &containers = young ? _youngContainers : _oldContainers;
+    object->_young = young;
+    object->_nextTracked = containers;
+    if (containers) {
+        containers->_previousTracked = object;
     }
-    for (auto *ptr : expired) {
-        deregisterContainer(ptr);
+    containers = object;
+    if (young) {
+        _youngContainerCount++;
     }
 }
 
-void VirtualMachine::deregisterContainer(Object *object) {
-    auto sizeIt = _containerSizes.find(object);
-    if (sizeIt != _containerSizes.end()) {
-        size_t previous = sizeIt->second;
-        if (_liveContainerBytes >= previous) {
-            _liveContainerBytes -= previous;
-        } else {
-            _liveContainerBytes = 0;
-        }
-        _containerSizes.erase(sizeIt);
+void VirtualMachine::unlinkContainer(TrackedObject *object) {
+    if (object->_previousTracked) {
+        object->_previousTracked->_nextTracked = object->_nextTracked;
+    } else if (object->_young) {
+        _youngContainers = object->_nextTracked;
+    } else {
+        _oldContainers = object->_nextTracked;
+    }
+    if (object->_nextTracked) {
+        object->_nextTracked->_previousTracked = object->_previousTracked;
+    }
+    object->_previousTracked = nullptr;
+    object->_nextTracked = nullptr;
+    if (object->_young) {
+        _youngContainerCount--;
+    }
+    object->_young = false;
+}
+
+// A container that was mutated, or whose count dropped without reaching zero, may have closed or
+// been left in a garbage cycle, so it is examined again by the next young collection.
+void VirtualMachine::rememberContainer(TrackedObject *object) {
+    object->acyclic = false;
+    if (object->tracker == this && !object->_young && !_gcInProgress) {
+        unlinkContainer(object);
+        linkContainer(object, true);
     }
-    _trackedContainers.erase(object);
 }
 
-void VirtualMachine::accountForContainer(Object *object, size_t newSize, bool accumulateDebt) {
+void VirtualMachine::deregisterContainer(TrackedObject *object) {
+    _liveContainerBytes -= std::min(_liveContainerBytes, object->_trackedBytes);
+    object->_trackedBytes = 0;
+    unlinkContainer(object);
+    object->tracker = nullptr;
+    _trackedContainerCount--;
+}
+
+void VirtualMachine::accountForContainer(TrackedObject *object, size_t newSize,
+                                         bool accumulateDebt) {
     assert(object);
-    if (_trackedContainers.find(object) == _trackedContainers.end()) {
+    if (object->tracker != this) {
         return;
     }
-    auto &current = _containerSizes[object];
-    size_t previous = current;
+    size_t previous = object->_trackedBytes;
     if (newSize >= previous) {
         size_t delta = newSize - previous;
         if (delta > 0) {
@@ -808,7 +1341,8 @@ void VirtualMachine::accountForContainer(Object *object, size_t newSize, bool ac
             _liveContainerBytes = 0;
         }
     }
-    current = newSize;
+    object->_trackedBytes = newSize;
+    _gcStatistics.peakTrackedBytes = std::max(_gcStatistics.peakTrackedBytes, _liveContainerBytes);
     if (_nextGcThreshold == 0) {
         _nextGcThreshold = std::max(config.initialGarbageCollectionThresholdBytes,
                                     config.minimumGarbageCollectionThresholdBytes);
@@ -816,10 +1350,9 @@ void VirtualMachine::accountForContainer(Object *object, size_t newSize, bool ac
 }
 
 void VirtualMachine::refreshContainerMetrics(bool accumulateDebt) {
-    cleanupExpiredContainers();
-    for (auto &entry : _trackedContainers) {
-        if (auto locked = entry.second.lock()) {
-            accountForContainer(entry.first, estimateContainerSize(locked.get()), accumulateDebt);
+    for (auto *containers : {_youngContainers, _oldContainers}) {
+        for (auto *object = containers; object; object = object->_nextTracked) {
+            accountForContainer(object, estimateContainerSize(object), accumulateDebt);
         }
     }
 }
@@ -840,83 +1373,183 @@ void VirtualMachine::runPendingGarbageCollection() {
         return;
     }
 
-    // Clear out expired weak references so the collector only considers live candidates.
-    cleanupExpiredContainers();
-    if (_gcInProgress) {
-        return;
-    }
-
     _gcInProgress = true;
+    auto start = std::chrono::steady_clock::now();
+    auto previousCount = _garbageCollectionCount;
+    auto previousObjects = _heap->statistics().liveObjects;
+    auto previousBytes = _liveContainerBytes;
+
+    GarbageCollectionStatistics::Collection collection;
+    collection.full = _fullGcRequested || (config.automaticFullGarbageCollection &&
+                                           _liveContainerBytes >= _nextFullGcThreshold);
+    collection.objectsMarked =
+        collection.full ? collectAllContainers() : collectYoungContainers();
+    if (_garbageCollectionCount > previousCount) {
+        collection.pause = std::chrono::steady_clock::now() - start;
+        auto liveObjects = _heap->statistics().liveObjects;
+        collection.objectsFreed = previousObjects > liveObjects ? previousObjects - liveObjects : 0;
+        collection.bytesReclaimed =
+            previousBytes > _liveContainerBytes ? previousBytes - _liveContainerBytes : 0;
+        _gcStatistics.record(collection);
+    }
+    _gcInProgress = false;
+    _gcPending = false;
+    _fullGcRequested = false;
+}
 
-    size_t previousCount = _garbageCollectionCount;
-
-    // Hold strong references to every tracked container during the collection.
-    std::vector<Strong<Object>> strongRefs;
-    strongRefs.reserve(_trackedContainers.size());
+// Young collections need no roots. Every reference to an object is counted, so subtracting the
+// references that the examined objects hold to each other leaves the references from everywhere
+// else: roots, native code and the host. Examined containers reachable from those survive, and the
+// rest are only reachable through cycles among themselves.
+//
+// Young containers are the candidate roots of such cycles, and the subgraph reachable from them,
+// including old containers, is examined until the budget is spent. Objects that would exceed it
+// are treated like roots. Leaves, and containers that refer only to leaves, cannot be part of a
+// cycle and are never examined, so that dropping a reference to a large live container does not
+// walk it again.
+size_t VirtualMachine::collectYoungContainers() {
+    // Untracked objects reached from examined ones, such as shared elements and enumerators, are
+    // examined too, and count against the budget, so that cycles through them are found. Objects
+    // that are not TrackedObjects are treated as roots and never examined: functions trace the
+    // constants of their bytecode, which is referenced from elsewhere.
+    auto &examined = _tracer.worklist;
+    _tracer.phase = Tracer::Phase::Subtract;
+    _tracer.examinedCount = 0;
+    _tracer.budget = config.youngGarbageCollectionBudget;
+    auto *candidate = _youngContainers;
+    for (size_t i = 0;;) {
+        if (i == examined.size()) {
+            while (candidate && candidate->visited) {
+                candidate = candidate->_nextTracked;
+            }
+            if (!candidate || (_tracer.budget > 0 && _tracer.examinedCount >= _tracer.budget)) {
+                break;
+            }
+            _tracer.examine(candidate);
+            continue;
+        }
+        auto *object = static_cast<TrackedObject *>(examined[i++]);
+        _tracer.references = 0;
+        object->trace(_tracer);
+        if (object->tracker == this) {
+            object->acyclic = _tracer.references == 0;
+        }
+    }
+    if (examined.empty()) {
+        _bytesSinceLastGc = 0;
+        return 0;
+    }
+    std::swap(examined, _collectedObjects);
 
-    // Snapshot every root we can reach (stack, globals, frames, transient native roots, etc.).
-    auto roots = gatherRootObjects();
+    _tracer.phase = Tracer::Phase::Restore;
+    for (auto *examined : _collectedObjects) {
+        if (static_cast<TrackedObject *>(examined)->_externalReferences > 0) {
+            _tracer.worklist.push_back(examined);
+        }
+    }
+    while (!_tracer.worklist.empty()) {
+        auto *current = _tracer.worklist.back();
+        _tracer.worklist.pop_back();
+        current->trace(_tracer);
+    }
 
-    std::vector<Object *> expired;
-    for (auto &entry : _trackedContainers) {
-        auto locked = entry.second.lock();
-        if (!locked) {
-            expired.push_back(entry.first);
+    size_t marked = 0;
+    for (auto *examined : _collectedObjects) {
+        auto *object = static_cast<TrackedObject *>(examined);
+        if (object->_externalReferences > 0) {
+            marked++;
+        }
+        if (object->tracker != this) {
             continue;
         }
-        locked->visited = false;
-        strongRefs.push_back(std::move(locked));
+        if (object->_externalReferences == 0) {
+            _collectedContainers.emplace_back(object);
+        } else if (object->_young) {
+            unlinkContainer(object);
+            linkContainer(object, false);
+            accountForContainer(object, estimateContainerSize(object), false);
+        }
     }
+    for (auto *object : _collectedObjects) {
+        object->visited = false;
+    }
+    _collectedObjects.clear();
 
-    for (auto *ptr : expired) {
-        deregisterContainer(ptr);
+    _tracer.phase = Tracer::Phase::Release;
+    for (auto &object : _collectedContainers) {
+        object->trace(_tracer);
     }
+    _collectedContainers.clear();
 
-    if (!strongRefs.empty()) {
-        // Depth-first mark over the object graph starting from the root set.
-        static const auto markReachable = [](Object *root) {
-            std::stack<Object *> stack;
-            stack.push(root);
-            while (!stack.empty()) {
-                auto *current = stack.top();
-                stack.pop();
-                if (current->visited) {
-                    continue;
-                }
-                current->visited = true;
-                current->trace([&stack](Strong<Object> &child) {
-                    if (child && !child->visited) {
-                        stack.push(child.get());
-                    }
-                });
+    _garbageCollectionCount++;
+
+    // The debt is paid once the whole nursery has been examined. Until then, each safepoint
+    // examines another slice of it.
+    if (_youngContainerCount == 0) {
+        _bytesSinceLastGc = 0;
+    }
+    return marked;
+}
+
+size_t VirtualMachine::collectAllContainers() {
+    size_t previousCount = _garbageCollectionCount;
+    size_t marked = 0;
+
+    if (_trackedContainerCount > 0) {
+        // Depth-first mark over the object graph starting from the root set: the stack, globals,
+        // frames and transient native roots. Untracked objects that were marked, such as functions
+        // and shared elements, are remembered so that they can be unmarked for the next collection.
+        _tracer.phase = Tracer::Phase::Mark;
+        traceRoots(_tracer);
+        while (!_tracer.worklist.empty()) {
+            auto *current = _tracer.worklist.back();
+            _tracer.worklist.pop_back();
+            marked++;
+            auto *tracked = ObjectCast<TrackedObject>(current);
+            if (!tracked || !tracked->tracker) {
+                _collectedObjects.push_back(current);
             }
-        };
+            _tracer.references = 0;
+            current->trace(_tracer);
+            if (tracked && tracked->tracker == this) {
+                tracked->acyclic = _tracer.references == 0;
+            }
+        }
 
-        for (auto &root : roots) {
-            if (root) {
-                markReachable(root.get());
+        // Hold strong references to the containers that were not marked, and promote the rest
+        // after refreshing their size accounting so thresholds stay accurate. Old containers come
+        // first, so that promoted ones are not visited twice.
+        for (auto *containers : {_oldContainers, _youngContainers}) {
+            for (auto *object = containers; object;) {
+                auto *next = object->_nextTracked;
+                if (!object->visited) {
+                    _collectedContainers.emplace_back(object);
+                } else {
+                    object->visited = false;
+                    accountForContainer(object, estimateContainerSize(object), false);
+                    if (object->_young) {
+                        unlinkContainer(object);
+                        linkContainer(object, false);
+                    }
+                }
+                object = next;
             }
         }
+        for (auto *object : _collectedObjects) {
+            object->visited = false;
+        }
+        _collectedObjects.clear();
 
         // Sweep: drop edges from any container that was not marked reachable.
-        for (auto &obj : strongRefs) {
-            if (!obj->visited) {
-                obj->trace([](Strong<Object> &child) { child.reset(); });
-            }
+        _tracer.phase = Tracer::Phase::Release;
+        for (auto &object : _collectedContainers) {
+            object->trace(_tracer);
         }
+        _collectedContainers.clear();
 
         _garbageCollectionCount++;
-
-        // Refresh size accounting for survivors so thresholds stay accurate.
-        for (auto &obj : strongRefs) {
-            if (obj && obj->visited) {
-                accountForContainer(obj.get(), estimateContainerSize(obj.get()), false);
-            }
-        }
     }
 
-    _gcInProgress = false;
-
     if (_garbageCollectionCount > previousCount) {
         double growth = std::max(1.0, config.garbageCollectionGrowthFactor);
         size_t baseline = std::max(config.initialGarbageCollectionThresholdBytes,
@@ -927,12 +1560,10 @@ void VirtualMachine::runPendingGarbageCollection() {
                 baseline,
                 static_cast<size_t>(std::ceil(static_cast<double>(_liveContainerBytes) * growth)));
         }
-        _nextGcThreshold = nextThreshold;
+        _nextFullGcThreshold = nextThreshold;
         _bytesSinceLastGc = 0;
     }
-
-    _gcPending = false;
-    cleanupExpiredContainers();
+    return marked;
 }
 
 SIF_NAMESPACE_END
@@ -19,6 +19,7 @@
 
 #include "sif/runtime/modules/Core.h"
 #include "sif/runtime/objects/Dictionary.h"
+#include "sif/runtime/objects/HashSet.h"
 #include "sif/runtime/objects/List.h"
 #include "sif/runtime/objects/Native.h"
 #include "sif/runtime/objects/String.h"
@@ -31,6 +32,7 @@
 #include <cmath>
 #include <format>
 #include <limits>
+#include <numeric>
 #include <random>
 #include <utility>
 
@@ -59,6 +61,8 @@ inline constexpr std::string_view ExpectedAList = "expected a list";
 inline constexpr std::string_view ExpectedAnInteger = "expected an integer";
 inline constexpr std::string_view ExpectedANumber = "expected a number";
 inline constexpr std::string_view ExpectedARange = "expected a range";
+inline constexpr std::string_view ExpectedASet = "expected a set";
+inline constexpr std::string_view ExpectedListDictOrSet = "expected a list, dictionary or set";
 inline constexpr std::string_view ExpectedIntegerOrRange = "expected an integer or range";
 inline constexpr std::string_view ExpectedListOrDictionary = "expected a list or dictionary";
 inline constexpr std::string_view ExpectedStringOrList = "expected a string or list";
@@ -72,6 +76,15 @@ inline constexpr std::string_view NotEnoughFormatArgs = "not enough arguments fo
 inline constexpr std::string_view UnterminatedFormat = "unterminated placeholder in format string";
 } // namespace Errors
 
+// String literals are shared with the bytecode that pushed them, so natives that modify a string
+// in place work on a copy of a literal and return that instead.
+static Strong<String> Mutable(const NativeCallContext &context, Strong<String> string) {
+    if (string && string->literal) {
+        return Cast<String>(string->copy(context.vm));
+    }
+    return string;
+}
+
 static auto _the_language_version(const NativeCallContext &context) -> Result<Value, Error> {
     return Value(std::string(Version));
 }
@@ -152,20 +165,29 @@ static bool _case_insensitive_lexicographic_compare(const std::string &a, const
 
 static auto _sort_list(const NativeCallContext &context, Strong<List> list)
     -> Result<Value, Error> {
+    if (list->storage() != List::Storage::Values) {
+        list->visit([](auto &elements) {
+            if constexpr (!std::is_same_v<typename std::decay_t<decltype(elements)>::value_type,
+                                          Value>) {
+                std::sort(elements.begin(), elements.end());
+            }
+        });
+        return Value(list);
+    }
+    auto &values = list->values();
     try {
-        std::sort(
-            list->values().begin(), list->values().end(), [&](const Value &a, const Value &b) {
-                if (a.isInteger() && b.isInteger()) {
-                    return a.asInteger() < b.asInteger();
-                } else if (a.isNumber() && b.isNumber()) {
-                    return a.castFloat() < b.castFloat();
-                } else if (a.isString() && b.isString()) {
-                    return _case_insensitive_lexicographic_compare(a.toString(), b.toString());
-                }
-                throw Error(context.location, Errors::CantCompare, a.toString(), a.typeName(),
-                            b.toString(), b.typeName());
-                return true;
-            });
+        std::sort(values.begin(), values.end(), [&](const Value &a, const Value &b) {
+            if (a.isInteger() && b.isInteger()) {
+                return a.asInteger() < b.asInteger();
+            } else if (a.isNumber() && b.isNumber()) {
+                return a.castFloat() < b.castFloat();
+            } else if (a.isString() && b.isString()) {
+                return _case_insensitive_lexicographic_compare(a.toString(), b.toString());
+            }
+            throw Error(context.location, Errors::CantCompare, a.toString(), a.typeName(),
+                        b.toString(), b.typeName());
+            return true;
+        });
     } catch (const Error &error) {
         return Fail(error);
     }
@@ -196,9 +218,11 @@ static auto _sort_T(const NativeCallContext &context) -> Result<Value, Error> {
 static auto _the_size_of_T(const NativeCallContext &context) -> Result<Value, Error> {
     size_t size = 0;
     if (auto list = context.arguments[0].as<List>()) {
-        size = list->values().size();
+        size = list->size();
     } else if (auto dictionary = context.arguments[0].as<Dictionary>()) {
-        size = dictionary->values().size();
+        size = std::as_const(*dictionary).values().size();
+    } else if (auto set = context.arguments[0].as<HashSet>()) {
+        size = set->size();
     } else if (auto string = context.arguments[0].as<String>()) {
         size = string->string().size();
     } else if (auto range = context.arguments[0].as<Range>()) {
@@ -212,9 +236,11 @@ static auto _the_size_of_T(const NativeCallContext &context) -> Result<Value, Er
 static auto _T_is_T(const NativeCallContext &context) -> Result<Value, Error> {
     if (context.arguments[1].isEmpty()) {
         if (auto list = context.arguments[0].as<List>()) {
-            return list->values().size() == 0;
+            return list->empty();
         } else if (auto dictionary = context.arguments[0].as<Dictionary>()) {
-            return dictionary->values().size() == 0;
+            return std::as_const(*dictionary).values().size() == 0;
+        } else if (auto set = context.arguments[0].as<HashSet>()) {
+            return set->empty();
         } else if (auto string = context.arguments[0].as<String>()) {
             return string->string().size() == 0;
         } else if (auto range = context.arguments[0].as<Range>()) {
@@ -227,9 +253,11 @@ static auto _T_is_T(const NativeCallContext &context) -> Result<Value, Error> {
 static auto _T_is_not_T(const NativeCallContext &context) -> Result<Value, Error> {
     if (context.arguments[1].isEmpty()) {
         if (auto list = context.arguments[0].as<List>()) {
-            return list->values().size() != 0;
+            return !list->empty();
         } else if (auto dictionary = context.arguments[0].as<Dictionary>()) {
-            return dictionary->values().size() != 0;
+            return std::as_const(*dictionary).values().size() != 0;
+        } else if (auto set = context.arguments[0].as<HashSet>()) {
+            return !set->empty();
         } else if (auto string = context.arguments[0].as<String>()) {
             return string->string().size() != 0;
         } else if (auto range = context.arguments[0].as<Range>()) {
@@ -247,6 +275,8 @@ static auto _contains(const NativeCallContext &context, int containerIndex, int
         return list->contains(value);
     } else if (auto dictionary = object.as<Dictionary>()) {
         return dictionary->contains(value);
+    } else if (auto set = object.as<HashSet>()) {
+        return set->contains(value);
     } else if (auto string = object.as<String>()) {
         if (auto lookup = value.as<String>()) {
             return string->string().find(lookup->string()) != std::string::npos;
@@ -404,8 +434,7 @@ static auto _items_T_to_T_in_T(const NativeCallContext &context) -> Result<Value
     if (auto list = context.arguments[2].as<List>()) {
         auto index1 = context.arguments[0].asInteger();
         auto index2 = context.arguments[1].asInteger();
-        auto result = context.vm.make<List>(list->values().begin() + index1,
-                                            list->values().begin() + index2 + 1);
+        auto result = context.vm.make<List>(list->slice(index1, index2 + 1));
         context.vm.notifyContainerMutation(result.get());
         return result;
     } else if (auto string = context.arguments[2].as<String>()) {
@@ -452,14 +481,15 @@ static auto _items_T_to_T_in_T_using_delimiter_T(const NativeCallContext &contex
 static auto _insert_T_at_the_beginning_of_T(const NativeCallContext &context)
     -> Result<Value, Error> {
     if (auto list = context.arguments[1].as<List>()) {
-        list->values().insert(list->values().begin(), context.arguments[0]);
+        list->insert(0, context.vm.own(context.arguments[0]));
         context.vm.notifyContainerMutation(list.get());
-    } else if (auto string = context.arguments[1].as<String>()) {
+    } else if (auto string = Mutable(context, context.arguments[1].as<String>())) {
         auto insertText = context.arguments[0].as<String>();
         if (!insertText) {
             return Fail(context.argumentError(0, Errors::ExpectedAString));
         }
         string->string().insert(0, insertText->string());
+        return string;
     } else {
         return Fail(context.argumentError(1, Errors::ExpectedStringOrList));
     }
@@ -468,14 +498,15 @@ static auto _insert_T_at_the_beginning_of_T(const NativeCallContext &context)
 
 static auto _insert_T_at_the_end_of_T(const NativeCallContext &context) -> Result<Value, Error> {
     if (auto list = context.arguments[1].as<List>()) {
-        list->values().push_back(context.arguments[0]);
+        list->append(context.vm.own(context.arguments[0]));
         context.vm.notifyContainerMutation(list.get());
-    } else if (auto string = context.arguments[1].as<String>()) {
+    } else if (auto string = Mutable(context, context.arguments[1].as<String>())) {
         auto insertText = context.arguments[0].as<String>();
         if (!insertText) {
             return Fail(context.argumentError(0, Errors::ExpectedAString));
         }
         string->string().append(insertText->string());
+        return string;
     } else {
         return Fail(context.argumentError(1, Errors::ExpectedStringOrList));
     }
@@ -484,7 +515,7 @@ static auto _insert_T_at_the_end_of_T(const NativeCallContext &context) -> Resul
 
 static auto _push_T_onto_T(const NativeCallContext &context) -> Result<Value, Error> {
     if (auto list = context.arguments[1].as<List>()) {
-        list->values().push_back(context.arguments[0]);
+        list->append(context.vm.own(context.arguments[0]));
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -496,8 +527,8 @@ static auto _pop_from_T(const NativeCallContext &context) -> Result<Value, Error
         if (list->size() == 0) {
             return Value();
         }
-        auto value = list->values().back();
-        list->values().pop_back();
+        auto value = list->at(list->size() - 1);
+        list->erase(list->size() - 1, list->size());
         context.vm.notifyContainerMutation(list.get());
         return value;
     }
@@ -510,7 +541,7 @@ static auto _remove_the_first_item_from_T(const NativeCallContext &context)
         if (list->size() == 0) {
             return Value();
         }
-        list->values().erase(list->values().begin());
+        list->erase(0, 1);
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -522,7 +553,7 @@ static auto _remove_the_last_item_from_T(const NativeCallContext &context) -> Re
         if (list->size() == 0) {
             return Value();
         }
-        list->values().pop_back();
+        list->erase(list->size() - 1, list->size());
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -539,7 +570,7 @@ static auto _remove_item_T_from_T(const NativeCallContext &context) -> Result<Va
             return Fail(context.argumentError(0, Errors::ExpectedAnInteger));
         }
         auto index = context.arguments[0].asInteger();
-        list->values().erase(list->values().begin() + index);
+        list->erase(index, index + 1);
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -581,7 +612,7 @@ static auto _the_last_offset_of_T_in_T(const NativeCallContext &context) -> Resu
 }
 
 static auto _replace_all_T_with_T_in_T(const NativeCallContext &context) -> Result<Value, Error> {
-    if (auto text = context.arguments[2].as<String>()) {
+    if (auto text = Mutable(context, context.arguments[2].as<String>())) {
         auto searchString = context.arguments[0].as<String>();
         if (!searchString) {
             return Fail(context.argumentError(0, Errors::ExpectedAString));
@@ -593,7 +624,7 @@ static auto _replace_all_T_with_T_in_T(const NativeCallContext &context) -> Resu
         text->replaceAll(*searchString, *replacementString);
         return text;
     } else if (auto list = context.arguments[2].as<List>()) {
-        list->replaceAll(context.arguments[0], context.arguments[1]);
+        list->replaceAll(context.arguments[0], context.vm.own(context.arguments[1]));
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -601,7 +632,7 @@ static auto _replace_all_T_with_T_in_T(const NativeCallContext &context) -> Resu
 }
 
 static auto _replace_first_T_with_T_in_T(const NativeCallContext &context) -> Result<Value, Error> {
-    if (auto text = context.arguments[2].as<String>()) {
+    if (auto text = Mutable(context, context.arguments[2].as<String>())) {
         auto searchString = context.arguments[0].as<String>();
         if (!searchString) {
             return Fail(context.argumentError(0, Errors::ExpectedAString));
@@ -613,7 +644,7 @@ static auto _replace_first_T_with_T_in_T(const NativeCallContext &context) -> Re
         text->replaceFirst(*searchString, *replacementString);
         return text;
     } else if (auto list = context.arguments[2].as<List>()) {
-        list->replaceFirst(context.arguments[0], context.arguments[1]);
+        list->replaceFirst(context.arguments[0], context.vm.own(context.arguments[1]));
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -621,7 +652,7 @@ static auto _replace_first_T_with_T_in_T(const NativeCallContext &context) -> Re
 }
 
 static auto _replace_last_T_with_T_in_T(const NativeCallContext &context) -> Result<Value, Error> {
-    if (auto text = context.arguments[2].as<String>()) {
+    if (auto text = Mutable(context, context.arguments[2].as<String>())) {
         auto searchString = context.arguments[0].as<String>();
         if (!searchString) {
             return Fail(context.argumentError(0, Errors::ExpectedAString));
@@ -633,7 +664,7 @@ static auto _replace_last_T_with_T_in_T(const NativeCallContext &context) -> Res
         text->replaceLast(*searchString, *replacementString);
         return text;
     } else if (auto list = context.arguments[2].as<List>()) {
-        list->replaceLast(context.arguments[0], context.arguments[1]);
+        list->replaceLast(context.arguments[0], context.vm.own(context.arguments[1]));
         context.vm.notifyContainerMutation(list.get());
         return list;
     }
@@ -691,6 +722,10 @@ static auto _T_is_a_dictionary(const NativeCallContext &context) -> Result<Value
     return context.arguments[0].as<Dictionary>() != nullptr;
 }
 
+static auto _T_is_a_set(const NativeCallContext &context) -> Result<Value, Error> {
+    return context.arguments[0].as<HashSet>() != nullptr;
+}
+
 static auto _an_empty_string(const NativeCallContext &context) -> Result<Value, Error> {
     return Value(std::string());
 }
@@ -703,14 +738,36 @@ static auto _an_empty_dictionary(const NativeCallContext &context) -> Result<Val
     return Value(context.vm.make<Dictionary>());
 }
 
+static auto _an_empty_set(const NativeCallContext &context) -> Result<Value, Error> {
+    return Value(context.vm.make<HashSet>());
+}
+
+static auto _T_as_a_set(const NativeCallContext &context) -> Result<Value, Error> {
+    if (auto list = context.arguments[0].as<List>()) {
+        return std::as_const(*list).visit([&](const auto &elements) -> Value {
+            return context.vm.make<HashSet>(elements.begin(), elements.end());
+        });
+    } else if (auto dictionary = context.arguments[0].as<Dictionary>()) {
+        ValueMap elements;
+        for (const auto &pair : std::as_const(*dictionary).values()) {
+            elements.emplace(pair.first, Value());
+        }
+        return context.vm.make<HashSet>(std::move(elements));
+    } else if (auto set = context.arguments[0].as<HashSet>()) {
+        return set->copy(context.vm);
+    }
+    return Fail(context.argumentError(0, Errors::ExpectedListDictOrSet));
+}
+
 static auto _the_keys_of_T(const NativeCallContext &context) -> Result<Value, Error> {
     auto dictionary = context.arguments[0].as<Dictionary>();
     if (!dictionary) {
         return Fail(context.argumentError(0, Errors::ExpectedADictionary));
     }
     std::vector<Value> keys;
-    keys.reserve(dictionary->values().size());
-    for (const auto &pair : dictionary->values()) {
+    const auto &entries = std::as_const(*dictionary).values();
+    keys.reserve(entries.size());
+    for (const auto &pair : entries) {
         keys.emplace_back(pair.first);
     }
     return context.vm.make<List>(std::move(keys));
@@ -722,8 +779,9 @@ static auto _the_values_of_T(const NativeCallContext &context) -> Result<Value,
         return Fail(context.argumentError(0, Errors::ExpectedADictionary));
     }
     std::vector<Value> values;
-    values.reserve(dictionary->values().size());
-    for (const auto &pair : dictionary->values()) {
+    const auto &entries = std::as_const(*dictionary).values();
+    values.reserve(entries.size());
+    for (const auto &pair : entries) {
         values.emplace_back(pair.second);
     }
     return context.vm.make<List>(std::move(values));
@@ -735,11 +793,80 @@ static auto _insert_item_T_with_key_T_into_T(const NativeCallContext &context)
     if (!dictionary) {
         return Fail(context.argumentError(2, Errors::ExpectedADictionary));
     }
-    dictionary->values()[context.arguments[1]] = context.arguments[0];
+    auto key = context.vm.own(context.arguments[1]);
+    dictionary->values()[key] = context.vm.own(context.arguments[0]);
     context.vm.notifyContainerMutation(dictionary.get());
     return dictionary;
 }
 
+static auto _add_T_to_T(const NativeCallContext &context) -> Result<Value, Error> {
+    auto set = context.arguments[1].as<HashSet>();
+    if (!set) {
+        return Fail(context.argumentError(1, Errors::ExpectedASet));
+    }
+    set->insert(context.vm.own(context.arguments[0]));
+    context.vm.notifyContainerMutation(set.get());
+    return set;
+}
+
+static auto _remove_T_from_T(const NativeCallContext &context) -> Result<Value, Error> {
+    auto set = context.arguments[1].as<HashSet>();
+    if (!set) {
+        return Fail(context.argumentError(1, Errors::ExpectedASet));
+    }
+    set->erase(context.arguments[0]);
+    context.vm.notifyContainerMutation(set.get());
+    return set;
+}
+
+// Calls combine with both sets, and returns a new set with the elements it chooses.
+template <typename Combine>
+static auto _combine_sets(const NativeCallContext &context, Combine combine)
+    -> Result<Value, Error> {
+    auto set = context.arguments[0].as<HashSet>();
+    if (!set) {
+        return Fail(context.argumentError(0, Errors::ExpectedASet));
+    }
+    auto other = context.arguments[1].as<HashSet>();
+    if (!other) {
+        return Fail(context.argumentError(1, Errors::ExpectedASet));
+    }
+    ValueMap elements;
+    combine(*set, *other, elements);
+    return context.vm.make<HashSet>(std::move(elements));
+}
+
+static auto _the_union_of_T_and_T(const NativeCallContext &context) -> Result<Value, Error> {
+    return _combine_sets(context, [](const HashSet &set, const HashSet &other, ValueMap &result) {
+        result = set.elements();
+        for (const auto &entry : other.elements()) {
+            result.emplace(entry.first, Value());
+        }
+    });
+}
+
+static auto _the_intersection_of_T_and_T(const NativeCallContext &context)
+    -> Result<Value, Error> {
+    return _combine_sets(context, [](const HashSet &set, const HashSet &other, ValueMap &result) {
+        for (const auto &entry : set.elements()) {
+            if (other.contains(entry.first)) {
+                result.emplace(entry.first, Value());
+            }
+        }
+    });
+}
+
+static auto _the_difference_of_T_and_T(const NativeCallContext &context)
+    -> Result<Value, Error> {
+    return _combine_sets(context, [](const HashSet &set, const HashSet &other, ValueMap &result) {
+        for (const auto &entry : set.elements()) {
+            if (!other.contains(entry.first)) {
+                result.emplace(entry.first, Value());
+            }
+        }
+    });
+}
+
 static auto _the_first_item_in_T(const NativeCallContext &context) -> Result<Value, Error> {
     auto list = context.arguments[0].as<List>();
     if (!list) {
@@ -748,7 +875,7 @@ static auto _the_first_item_in_T(const NativeCallContext &context) -> Result<Val
     if (list->size() == 0) {
         return Value();
     }
-    return list->values().at(0);
+    return list->at(0);
 }
 
 static auto _the_middle_item_in_T(const NativeCallContext &context) -> Result<Value, Error> {
@@ -759,7 +886,7 @@ static auto _the_middle_item_in_T(const NativeCallContext &context) -> Result<Va
     if (list->size() == 0) {
         return Value();
     }
-    return list->values().at(list->values().size() / 2);
+    return list->at(list->size() / 2);
 }
 
 static auto _the_last_item_in_T(const NativeCallContext &context) -> Result<Value, Error> {
@@ -770,7 +897,7 @@ static auto _the_last_item_in_T(const NativeCallContext &context) -> Result<Valu
     if (list->size() == 0) {
         return Value();
     }
-    return list->values().back();
+    return list->at(list->size() - 1);
 }
 
 static auto _the_number_of_items_in_T(const NativeCallContext &context) -> Result<Value, Error> {
@@ -778,7 +905,7 @@ static auto _the_number_of_items_in_T(const NativeCallContext &context) -> Resul
     if (!list) {
         return Fail(context.argumentError(0, Errors::ExpectedAList));
     }
-    return Integer(list->values().size());
+    return Integer(list->size());
 }
 
 static auto _any_item_in_T(std::function<Integer(Integer)> randomInteger)
@@ -788,7 +915,10 @@ static auto _any_item_in_T(std::function<Integer(Integer)> randomInteger)
         if (!list) {
             return Fail(context.argumentError(0, Errors::ExpectedAList));
         }
-        return list->values().at(randomInteger(list->values().size()));
+        if (list->empty()) {
+            return Value();
+        }
+        return list->at(randomInteger(list->size()));
     };
 }
 
@@ -805,7 +935,7 @@ static auto _remove_items_T_to_T_from_T(const NativeCallContext &context) -> Res
     }
     auto index1 = context.arguments[0].asInteger();
     auto index2 = context.arguments[1].asInteger();
-    list->values().erase(list->values().begin() + index1, list->values().begin() + index2 + 1);
+    list->erase(index1, index2 + 1);
     context.vm.notifyContainerMutation(list.get());
     return list;
 }
@@ -819,7 +949,7 @@ static auto _insert_T_at_index_T_into_T(const NativeCallContext &context) -> Res
         return Fail(context.argumentError(1, Errors::ExpectedAnInteger));
     }
     auto index = context.arguments[1].asInteger();
-    list->values().insert(list->values().begin() + index, context.arguments[0]);
+    list->insert(index, context.vm.own(context.arguments[0]));
     context.vm.notifyContainerMutation(list.get());
     return list;
 }
@@ -831,12 +961,12 @@ static auto _reverse_T(const NativeCallContext &context) -> Result<Value, Error>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
 #endif
-        std::reverse(list->values().begin(), list->values().end());
+        list->visit([](auto &elements) { std::reverse(elements.begin(), elements.end()); });
 #if defined(__GNUC__) && !defined(__clang__)
 #pragma GCC diagnostic pop
 #endif
         return list;
-    } else if (auto string = context.arguments[0].as<String>()) {
+    } else if (auto string = Mutable(context, context.arguments[0].as<String>())) {
         // Extract UTF-8 characters
         std::vector<std::string> characters;
         size_t index = 0;
@@ -860,7 +990,9 @@ static auto _reverse_T(const NativeCallContext &context) -> Result<Value, Error>
 
 static auto _reversed_T(const NativeCallContext &context) -> Result<Value, Error> {
     if (auto list = context.arguments[0].as<List>()) {
-        return context.vm.make<List>(list->values().rbegin(), list->values().rend());
+        auto result = context.vm.make<List>(list->elements());
+        result->visit([](auto &elements) { std::reverse(elements.begin(), elements.end()); });
+        return result;
     } else if (auto string = context.arguments[0].as<String>()) {
         // Extract UTF-8 characters
         std::vector<std::string> characters;
@@ -889,7 +1021,8 @@ static auto _shuffle_T(std::mt19937_64 &engine)
         if (!list) {
             return Fail(context.argumentError(0, Errors::ExpectedAList));
         }
-        std::shuffle(list->values().begin(), list->values().end(), engine);
+        list->visit(
+            [&](auto &elements) { std::shuffle(elements.begin(), elements.end(), engine); });
         return list;
     };
 }
@@ -901,8 +1034,9 @@ static auto _shuffled_T(std::mt19937_64 &engine)
         if (!list) {
             return Fail(context.argumentError(0, Errors::ExpectedAList));
         }
-        auto result = context.vm.make<List>(list->values());
-        std::shuffle(result->values().begin(), result->values().end(), engine);
+        auto result = context.vm.make<List>(list->elements());
+        result->visit(
+            [&](auto &elements) { std::shuffle(elements.begin(), elements.end(), engine); });
         return result;
     };
 }
@@ -913,8 +1047,8 @@ static auto _join_T(const NativeCallContext &context) -> Result<Value, Error> {
         return Fail(context.argumentError(0, Errors::ExpectedAList));
     }
     std::ostringstream str;
-    for (auto it = list->values().begin(); it < list->values().end(); it++) {
-        str << it->toString();
+    for (size_t i = 0; i < list->size(); i++) {
+        str << list->at(i).toString();
     }
     return str.str();
 }
@@ -929,9 +1063,9 @@ static auto _join_T_using_T(const NativeCallContext &context) -> Result<Value, E
         return Fail(context.argumentError(1, Errors::ExpectedAString));
     }
     std::ostringstream str;
-    for (auto it = list->values().begin(); it < list->values().end(); it++) {
-        str << it->toString();
-        if (it + 1 < list->values().end()) {
+    for (size_t i = 0; i < list->size(); i++) {
+        str << list->at(i).toString();
+        if (i + 1 < list->size()) {
             str << joinString->string();
         }
     }
@@ -947,7 +1081,7 @@ static auto _insert_T_at_character_T_in_T(const NativeCallContext &context)
     if (!context.arguments[1].isInteger()) {
         return Fail(context.argumentError(1, Errors::ExpectedAnInteger));
     }
-    auto text = context.arguments[2].as<String>();
+    auto text = Mutable(context, context.arguments[2].as<String>());
     if (!text) {
         return Fail(context.argumentError(2, Errors::ExpectedAString));
     }
@@ -962,7 +1096,7 @@ static auto _remove_all_T_from_T(const NativeCallContext &context) -> Result<Val
     if (!removeText) {
         return Fail(context.argumentError(0, Errors::ExpectedAString));
     }
-    auto text = context.arguments[1].as<String>();
+    auto text = Mutable(context, context.arguments[1].as<String>());
     if (!text) {
         return Fail(context.argumentError(1, Errors::ExpectedAString));
     }
@@ -975,7 +1109,7 @@ static auto _remove_first_T_from_T(const NativeCallContext &context) -> Result<V
     if (!removeText) {
         return Fail(context.argumentError(0, Errors::ExpectedAString));
     }
-    auto text = context.arguments[1].as<String>();
+    auto text = Mutable(context, context.arguments[1].as<String>());
     if (!text) {
         return Fail(context.argumentError(1, Errors::ExpectedAString));
     }
@@ -988,7 +1122,7 @@ static auto _remove_last_T_from_T(const NativeCallContext &context) -> Result<Va
     if (!removeText) {
         return Fail(context.argumentError(0, Errors::ExpectedAString));
     }
-    auto text = context.arguments[1].as<String>();
+    auto text = Mutable(context, context.arguments[1].as<String>());
     if (!text) {
         return Fail(context.argumentError(1, Errors::ExpectedAString));
     }
@@ -1007,7 +1141,7 @@ static auto _replace_chunk_T_with_T_in_T(chunk::type chunkType)
         if (!replacement) {
             return Fail(context.argumentError(1, Errors::ExpectedAString));
         }
-        auto text = context.arguments[2].as<String>();
+        auto text = Mutable(context, context.arguments[2].as<String>());
         if (!text) {
             return Fail(context.argumentError(2, Errors::ExpectedAString));
         }
@@ -1030,7 +1164,7 @@ static auto _replace_chunks_T_to_T_with_T_in_T(chunk::type chunkType)
         if (!replacement) {
             return Fail(context.argumentError(2, Errors::ExpectedAString));
         }
-        auto text = context.arguments[3].as<String>();
+        auto text = Mutable(context, context.arguments[3].as<String>());
         if (!text) {
             return Fail(context.argumentError(3, Errors::ExpectedAString));
         }
@@ -1047,7 +1181,7 @@ static auto _remove_chunk_T_from_T(chunk::type chunkType)
             return Fail(context.argumentError(0, Errors::ExpectedAnInteger));
         }
         auto index = context.arguments[0].asInteger();
-        auto text = context.arguments[1].as<String>();
+        auto text = Mutable(context, context.arguments[1].as<String>());
         if (!text) {
             return Fail(context.argumentError(1, Errors::ExpectedAString));
         }
@@ -1068,7 +1202,7 @@ static auto _remove_chunks_T_to_T_from_T(chunk::type chunkType)
         }
         auto start = context.arguments[0].asInteger();
         auto end = context.arguments[1].asInteger();
-        auto text = context.arguments[2].as<String>();
+        auto text = Mutable(context, context.arguments[2].as<String>());
         if (!text) {
             return Fail(context.argumentError(2, Errors::ExpectedAString));
         }
@@ -1182,7 +1316,9 @@ static auto _format_string_T_with_T(const NativeCallContext &context) -> Result<
 
     std::vector<Value> args;
     if (auto list = context.arguments[1].as<List>()) {
-        args = list->values();
+        for (size_t i = 0; i < list->size(); i++) {
+            args.push_back(list->at(i));
+        }
     } else {
         args.push_back(context.arguments[1]);
     }
@@ -1337,15 +1473,22 @@ static auto _the_maximum_value_of_T(const NativeCallContext &context) -> Result<
     if (!list) {
         return Fail(context.argumentError(0, Errors::ExpectedAList));
     }
-    if (list->values().size() == 0) {
+    if (list->empty()) {
         return Fail(context.argumentError(0, Errors::ListIsEmpty));
     }
-    auto first = list->values().front();
+    if (auto integers = std::get_if<List::Vector<Integer>>(&list->elements())) {
+        return static_cast<Float>(*std::max_element(integers->begin(), integers->end()));
+    }
+    if (auto floats = std::get_if<List::Vector<Float>>(&list->elements())) {
+        return *std::max_element(floats->begin(), floats->end());
+    }
+    const auto &values = std::get<List::Vector<Value>>(list->elements());
+    auto first = values.front();
     if (!first.isNumber()) {
         return Fail(context.argumentError(0, Errors::ExpectedANumber));
     }
     auto max = first.castFloat();
-    for (auto it = list->values().begin() + 1; it < list->values().end(); it++) {
+    for (auto it = values.begin() + 1; it < values.end(); it++) {
         if (!it->isNumber()) {
             return Fail(context.argumentError(0, Errors::ExpectedANumber));
         }
@@ -1362,15 +1505,22 @@ static auto _the_minimum_value_of_T(const NativeCallContext &context) -> Result<
     if (!list) {
         return Fail(context.argumentError(0, Errors::ExpectedAList));
     }
-    if (list->values().size() == 0) {
+    if (list->empty()) {
         return Fail(context.argumentError(0, Errors::ListIsEmpty));
     }
-    auto first = list->values().front();
+    if (auto integers = std::get_if<List::Vector<Integer>>(&list->elements())) {
+        return static_cast<Float>(*std::min_element(integers->begin(), integers->end()));
+    }
+    if (auto floats = std::get_if<List::Vector<Float>>(&list->elements())) {
+        return *std::min_element(floats->begin(), floats->end());
+    }
+    const auto &values = std::get<List::Vector<Value>>(list->elements());
+    auto first = values.front();
     if (!first.isNumber()) {
         return Fail(context.argumentError(0, Errors::ExpectedANumber));
     }
     auto min = first.castFloat();
-    for (auto it = list->values().begin() + 1; it < list->values().end(); it++) {
+    for (auto it = values.begin() + 1; it < values.end(); it++) {
         if (!it->isNumber()) {
             return Fail(context.argumentError(0, Errors::ExpectedANumber));
         }
@@ -1387,21 +1537,32 @@ static auto _the_average_of_T(const NativeCallContext &context) -> Result<Value,
     if (!list) {
         return Fail(context.argumentError(0, Errors::ExpectedAList));
     }
-    if (list->values().size() == 0) {
+    if (list->empty()) {
         return Fail(context.argumentError(0, Errors::ListIsEmpty));
     }
-    auto first = list->values().front();
+    if (auto integers = std::get_if<List::Vector<Integer>>(&list->elements())) {
+        auto sum = std::accumulate(integers->begin() + 1, integers->end(),
+                                   static_cast<Float>(integers->front()),
+                                   [](Float sum, Integer value) { return sum + value; });
+        return sum / integers->size();
+    }
+    if (auto floats = std::get_if<List::Vector<Float>>(&list->elements())) {
+        return std::accumulate(floats->begin() + 1, floats->end(), floats->front()) /
+               floats->size();
+    }
+    const auto &values = std::get<List::Vector<Value>>(list->elements());
+    auto first = values.front();
     if (!first.isNumber()) {
         return Fail(context.argumentError(0, Errors::ExpectedANumber));
     }
     auto sum = first.castFloat();
-    for (auto it = list->values().begin() + 1; it < list->values().end(); it++) {
+    for (auto it = values.begin() + 1; it < values.end(); it++) {
         if (!it->isNumber()) {
             return Fail(context.argumentError(0, Errors::ExpectedANumber));
         }
         sum = sum + it->castFloat();
     }
-    return sum / list->values().size();
+    return sum / values.size();
 }
 
 static void _core(ModuleMap &natives) {
@@ -1466,9 +1627,12 @@ static void _types(ModuleMap &natives) {
     natives[S("{value} is (a/an) str/string")] = N(_T_is_a_string);
     natives[S("{value} is (a/an) list")] = N(_T_is_a_list);
     natives[S("{value} is (a/an) dict/dictionary")] = N(_T_is_a_dictionary);
+    natives[S("{value} is (a/an) set")] = N(_T_is_a_set);
     natives[S("an empty str/string")] = N(_an_empty_string);
     natives[S("an empty list")] = N(_an_empty_list);
     natives[S("an empty dict/dictionary")] = N(_an_empty_dictionary);
+    natives[S("an empty set")] = N(_an_empty_set);
+    natives[S("{value} as (a/an) set")] = N(_T_as_a_set);
 }
 
 static void _dictionary(ModuleMap &natives) {
@@ -1478,6 +1642,14 @@ static void _dictionary(ModuleMap &natives) {
         N(_insert_item_T_with_key_T_into_T);
 }
 
+static void _set(ModuleMap &natives) {
+    natives[S("add {value} to {set}")] = N(_add_T_to_T);
+    natives[S("remove {value} from {set}")] = N(_remove_T_from_T);
+    natives[S("(the) union (of) {set} and {other}")] = N(_the_union_of_T_and_T);
+    natives[S("(the) intersection (of) {set} and {other}")] = N(_the_intersection_of_T_and_T);
+    natives[S("(the) difference (of) {set} and {other}")] = N(_the_difference_of_T_and_T);
+}
+
 static void _list(ModuleMap &natives, std::mt19937_64 &engine,
                   std::function<Integer(Integer)> randomInteger) {
     natives[S("(the) first item (in/of) {list}")] = N(_the_first_item_in_T);
@@ -1615,6 +1787,7 @@ Core::Core(const CoreConfig &config) : _config(config) {
     _common(_natives);
     _types(_natives);
     _dictionary(_natives);
+    _set(_natives);
     _list(_natives, _config.engine, _config.randomInteger);
     _string(_natives, _config.engine, _config.randomInteger);
     _range(_natives, _config.engine, _config.randomInteger);
@@ -40,14 +40,20 @@ namespace Errors {
 inline constexpr std::string_view UnableToOpenFile = "unable to open file";
 }
 
+static std::string JoinItems(const List &list, const std::string &separator) {
+    return list.visit([&](const auto &elements) {
+        return Join(elements, separator, [](const auto &element) { return Value(element); });
+    });
+}
+
 static auto _write_T(std::ostream &out)
     -> std::function<Result<Value, Error>(const NativeCallContext &)> {
     return [&out](const NativeCallContext &context) -> Result<Value, Error> {
         if (const auto &list = context.arguments[0].as<List>()) {
-            if (list->values().empty()) {
+            if (list->empty()) {
                 out << "empty";
             } else {
-                out << Join(list->values(), " ");
+                out << JoinItems(*list, " ");
             }
         } else {
             out << context.arguments[0];
@@ -60,10 +66,10 @@ static auto _write_error_T(std::ostream &err)
     -> std::function<Result<Value, Error>(const NativeCallContext &)> {
     return [&err](const NativeCallContext &context) -> Result<Value, Error> {
         if (const auto &list = context.arguments[0].as<List>()) {
-            if (list->values().empty()) {
+            if (list->empty()) {
                 err << "empty";
             } else {
-                err << Join(list->values(), " ");
+                err << JoinItems(*list, " ");
             }
         } else {
             err << context.arguments[0];
@@ -76,10 +82,10 @@ static auto _print_T(std::ostream &out)
     -> std::function<Result<Value, Error>(const NativeCallContext &)> {
     return [&out](const NativeCallContext &context) -> Result<Value, Error> {
         if (const auto &list = context.arguments[0].as<List>()) {
-            if (list->values().empty()) {
+            if (list->empty()) {
                 out << "empty";
             } else {
-                out << Join(list->values(), " ");
+                out << JoinItems(*list, " ");
             }
         } else {
             out << context.arguments[0];
@@ -93,12 +99,10 @@ static auto _print_error_T(std::ostream &err)
     -> std::function<Result<Value, Error>(const NativeCallContext &)> {
     return [&err](const NativeCallContext &context) -> Result<Value, Error> {
         if (const auto &list = context.arguments[0].as<List>()) {
-            if (list->values().empty()) {
+            if (list->empty()) {
                 err << "empty";
             } else {
-                for (const auto &item : list->values()) {
-                    err << item;
-                }
+                err << JoinItems(*list, "");
             }
         } else {
             err << context.arguments[0];
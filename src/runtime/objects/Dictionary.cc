@@ -12,6 +12,7 @@
 //
 
 #include "sif/runtime/objects/Dictionary.h"
+#include "sif/runtime/Tracer.h"
 #include "sif/runtime/VirtualMachine.h"
 #include "sif/runtime/objects/List.h"
 
@@ -20,15 +21,42 @@
 
 SIF_NAMESPACE_BEGIN
 
-Dictionary::Dictionary() {}
+Dictionary::Dictionary() : TrackedObject(Kind::Dictionary) {}
 
-Dictionary::Dictionary(const ValueMap &values) : _values(values) {}
+Dictionary::Dictionary(const ValueMap &values) : TrackedObject(Kind::Dictionary), _values(values) {}
 
-Dictionary::Dictionary(ValueMap &&values) : _values(std::move(values)) {}
+Dictionary::Dictionary(ValueMap &&values)
+    : TrackedObject(Kind::Dictionary), _values(std::move(values)) {}
 
-ValueMap &Dictionary::values() { return _values; }
+Dictionary::~Dictionary() {
+    if (_shared && shared()->owner == this) {
+        shared()->owner = nullptr;
+    }
+}
+
+ValueMap &Dictionary::values() {
+    detach();
+    _hash.reset();
+    return _values;
+}
 
-const ValueMap &Dictionary::values() const { return _values; }
+const ValueMap &Dictionary::values() const { return _shared ? shared()->values : _values; }
+
+void Dictionary::detach() {
+    acyclic = false;
+    if (!_shared) {
+        return;
+    }
+    if (_shared->references() == 1) {
+        _values = std::move(shared()->values);
+    } else {
+        _values = shared()->values;
+        if (shared()->owner == this) {
+            shared()->owner = nullptr;
+        }
+    }
+    _shared.reset();
+}
 
 std::string Dictionary::typeName() const { return "dictionary"; }
 
@@ -45,8 +73,9 @@ std::string Dictionary::description(Set<const Object *> &visited) const {
 
     std::ostringstream ss;
     ss << "[";
-    auto it = _values.begin();
-    while (it != _values.end()) {
+    const auto &values = this->values();
+    auto it = values.begin();
+    while (it != values.end()) {
         if (it->first.isObject()) {
             ss << it->first.asObject()->description(visited);
         } else {
@@ -60,11 +89,11 @@ std::string Dictionary::description(Set<const Object *> &visited) const {
             ss << it->second.description();
         }
         it++;
-        if (it != _values.end()) {
+        if (it != values.end()) {
             ss << ", ";
         }
     }
-    if (_values.size() == 0) {
+    if (values.size() == 0) {
         ss << ":";
     }
     ss << "]";
@@ -75,24 +104,60 @@ std::string Dictionary::description(Set<const Object *> &visited) const {
 }
 
 bool Dictionary::equals(Strong<Object> object) const {
-    if (const auto &dictionary = Cast<Dictionary>(object)) {
-        return _values == dictionary->_values;
+    if (auto dictionary = ObjectCast<Dictionary>(object.get())) {
+        return values() == dictionary->values();
     }
     return false;
 }
 
+// Equal dictionaries may have been filled in different orders, so the hashes of their pairs are
+// summed rather than combined in order.
 size_t Dictionary::hash() const {
-    hasher h;
-    for (const auto &pair : _values) {
+    if (_hash) {
+        return _hash.value();
+    }
+    size_t sum = 0;
+    bool cacheable = true;
+    for (const auto &pair : values()) {
+        hasher h;
         h.hash(pair.first, Value::Hash());
         h.hash(pair.second, Value::Hash());
+        sum += h.value();
+        cacheable = cacheable && !pair.first.isObject() && !pair.second.isObject();
+    }
+    if (cacheable) {
+        _hash = sum;
     }
-    return h.value();
+    return sum;
 }
 
-bool Dictionary::contains(const Value &value) const { return _values.find(value) != _values.end(); }
+bool Dictionary::contains(const Value &value) const { return values().contains(value); }
 
-Strong<Object> Dictionary::copy(VirtualMachine &vm) const { return vm.make<Dictionary>(_values); }
+size_t Dictionary::reservedBytes() const {
+    if (_shared) {
+        if (!shared()->owner) {
+            shared()->owner = this;
+        } else if (shared()->owner != this) {
+            return 0;
+        }
+    }
+    return values().reservedBytes();
+}
+
+Strong<Object> Dictionary::copy(VirtualMachine &vm) const {
+    auto dictionary = vm.make<Dictionary>();
+    // Dictionaries the machine does not track are copied rather than shared, as lists are.
+    if (!_shared && tracker == &vm && !_values.empty()) {
+        _shared = vm.make<Shared>(std::move(_values), this);
+    }
+    if (_shared) {
+        dictionary->_shared = _shared;
+    } else {
+        dictionary->_values = _values;
+    }
+    dictionary->_hash = _hash;
+    return dictionary;
+}
 
 Value Dictionary::enumerator(Value self) const {
     return MakeStrong<DictionaryEnumerator>(self.as<Dictionary>());
@@ -100,8 +165,9 @@ Value Dictionary::enumerator(Value self) const {
 
 Result<Value, Error> Dictionary::subscript(VirtualMachine &vm, SourceLocation location,
                                            const Value &value) const {
-    auto it = _values.find(value);
-    if (it == _values.end()) {
+    const auto &values = this->values();
+    auto it = values.find(value);
+    if (it == values.end()) {
         return Value();
     } else {
         return it->second;
@@ -110,36 +176,60 @@ Result<Value, Error> Dictionary::subscript(VirtualMachine &vm, SourceLocation lo
 
 Result<Value, Error> Dictionary::setSubscript(VirtualMachine &vm, SourceLocation, const Value &key,
                                               Value value) {
-    _values[key] = value;
+    values()[key] = value;
     vm.notifyContainerMutation(this);
     return Value();
 }
 
-void Dictionary::trace(const std::function<void(Strong<Object> &)> &visitor) {
-    for (auto &pair : _values) {
+static void TraceValues(ValueMap &values, Tracer &tracer) {
+    for (auto &pair : values) {
         if (pair.first.isObject()) {
-            visitor(const_cast<Value &>(pair.first).reference());
+            tracer.visit(pair.first.reference());
         }
         if (pair.second.isObject()) {
-            visitor(pair.second.reference());
+            tracer.visit(pair.second.reference());
         }
     }
 }
 
+void Dictionary::trace(Tracer &tracer) {
+    // Shared values are traced once through the object that holds them.
+    if (_shared) {
+        tracer.visit(_shared);
+    } else {
+        TraceValues(_values, tracer);
+    }
+}
+
+void Dictionary::Shared::trace(Tracer &tracer) {
+    TraceValues(values, tracer);
+}
+
 #pragma mark - DictionaryEnumerator
 
 DictionaryEnumerator::DictionaryEnumerator(Strong<Dictionary> dictionary)
-    : _dictionary(dictionary), _it(dictionary->values().begin()) {}
+    : TrackedObject(Kind::DictionaryEnumerator), _dictionary(dictionary), _position(0) {}
 
 Dictionary *DictionaryEnumerator::ptr() const { return static_cast<Dictionary *>(_dictionary.get()); }
 
 Value DictionaryEnumerator::enumerate() {
-    auto &&pair = *_it;
-    _it++;
-    return MakeStrong<List>(std::vector{pair.first, pair.second});
+    Value entry[2];
+    enumerateEntry(entry[0], entry[1]);
+    return MakeStrong<List>(std::begin(entry), std::end(entry));
 }
 
-bool DictionaryEnumerator::isAtEnd() { return _it == ptr()->values().end(); }
+void DictionaryEnumerator::enumerateEntry(Value &key, Value &value) {
+    const auto &values = std::as_const(*ptr()).values();
+    auto it = values.seek(_position);
+    _position = values.position(it) + 1;
+    key = it->first;
+    value = it->second;
+}
+
+bool DictionaryEnumerator::isAtEnd() {
+    const auto &values = std::as_const(*ptr()).values();
+    return values.seek(_position) == values.end();
+}
 
 std::string DictionaryEnumerator::typeName() const { return "DictionaryEnumerator"; }
 
@@ -147,8 +237,8 @@ std::string DictionaryEnumerator::description() const {
     return Concat("E(", ptr()->description(), ")");
 }
 
-void DictionaryEnumerator::trace(const std::function<void(Strong<Object> &)> &visitor) {
-    visitor(_dictionary);
+void DictionaryEnumerator::trace(Tracer &tracer) {
+    tracer.visit(_dictionary);
 }
 
 SIF_NAMESPACE_END
@@ -12,12 +12,13 @@
 //
 
 #include "sif/runtime/objects/Function.h"
+#include "sif/runtime/Tracer.h"
 
 SIF_NAMESPACE_BEGIN
 
 Function::Function(const Signature &signature, const Strong<Bytecode> &bytecode,
                    const std::vector<Capture> &captures)
-    : _signature(signature), _bytecode(bytecode), _captures(captures) {}
+    : Object(Kind::Function), _signature(signature), _bytecode(bytecode), _captures(captures) {}
 
 const Strong<Bytecode> &Function::bytecode() const { return _bytecode; }
 const std::vector<Function::Capture> &Function::captures() const { return _captures; }
@@ -26,10 +27,10 @@ std::string Function::typeName() const { return "function"; }
 
 std::string Function::description() const { return _signature.name(); }
 
-void Function::trace(const std::function<void(Strong<Object> &)> &visitor) {
+void Function::trace(Tracer &tracer) {
     for (auto &constant : _bytecode->constants()) {
         if (constant.isObject()) {
-            visitor(constant.reference());
+            tracer.visit(constant.reference());
         }
     }
 }
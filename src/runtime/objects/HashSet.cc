@@ -0,0 +1,150 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "sif/runtime/objects/HashSet.h"
+#include "sif/runtime/Tracer.h"
+#include "sif/runtime/VirtualMachine.h"
+
+#include "utilities/hasher.h"
+#include <sif/Utilities.h>
+
+SIF_NAMESPACE_BEGIN
+
+HashSet::HashSet() : TrackedObject(Kind::HashSet) {}
+
+HashSet::HashSet(const ValueMap &elements)
+    : TrackedObject(Kind::HashSet), _elements(elements) {}
+
+HashSet::HashSet(ValueMap &&elements)
+    : TrackedObject(Kind::HashSet), _elements(std::move(elements)) {}
+
+bool HashSet::insert(const Value &value) {
+    _hash.reset();
+    acyclic = false;
+    return _elements.emplace(value, Value()).second;
+}
+
+bool HashSet::erase(const Value &value) {
+    _hash.reset();
+    return _elements.erase(value) > 0;
+}
+
+std::string HashSet::typeName() const { return "set"; }
+
+std::string HashSet::description() const {
+    Set<const Object *> visited;
+    return description(visited);
+}
+
+std::string HashSet::description(Set<const Object *> &visited) const {
+    if (visited.find(this) != visited.end()) {
+        return "{...}";
+    }
+    visited.insert(this);
+
+    std::ostringstream ss;
+    ss << "{";
+    auto it = _elements.begin();
+    while (it != _elements.end()) {
+        if (it->first.isObject()) {
+            ss << it->first.asObject()->description(visited);
+        } else {
+            ss << it->first.description();
+        }
+        it++;
+        if (it != _elements.end()) {
+            ss << ", ";
+        }
+    }
+    ss << "}";
+
+    // Remove this object from visited set (for other branches)
+    visited.erase(this);
+    return ss.str();
+}
+
+bool HashSet::equals(Strong<Object> object) const {
+    if (auto set = ObjectCast<HashSet>(object.get())) {
+        return _elements == set->_elements;
+    }
+    return false;
+}
+
+// Equal sets may have been filled in different orders, so the hashes of their elements are summed
+// rather than combined in order.
+size_t HashSet::hash() const {
+    if (_hash) {
+        return _hash.value();
+    }
+    size_t sum = 0;
+    bool cacheable = true;
+    for (const auto &entry : _elements) {
+        sum += Value::Hash()(entry.first);
+        cacheable = cacheable && !entry.first.isObject();
+    }
+    if (cacheable) {
+        _hash = sum;
+    }
+    return sum;
+}
+
+Strong<Object> HashSet::copy(VirtualMachine &vm) const { return vm.make<HashSet>(_elements); }
+
+Value HashSet::enumerator(Value self) const {
+    return MakeStrong<HashSetEnumerator>(self.as<HashSet>());
+}
+
+void HashSet::trace(Tracer &tracer) {
+    for (auto &entry : _elements) {
+        if (entry.first.isObject()) {
+            tracer.visit(entry.first.reference());
+        }
+    }
+}
+
+#pragma mark - HashSetEnumerator
+
+HashSetEnumerator::HashSetEnumerator(Strong<HashSet> set)
+    : TrackedObject(Kind::HashSetEnumerator), _set(set), _position(0) {}
+
+HashSet *HashSetEnumerator::ptr() const { return static_cast<HashSet *>(_set.get()); }
+
+Value HashSetEnumerator::enumerate() {
+    const auto &elements = ptr()->elements();
+    auto it = elements.seek(_position);
+    if (it == elements.end()) {
+        return Value();
+    }
+    _position = elements.position(it) + 1;
+    return it->first;
+}
+
+bool HashSetEnumerator::isAtEnd() {
+    const auto &elements = ptr()->elements();
+    return elements.seek(_position) == elements.end();
+}
+
+std::string HashSetEnumerator::typeName() const { return "HashSetEnumerator"; }
+
+std::string HashSetEnumerator::description() const {
+    return Concat("E(", ptr()->description(), ")");
+}
+
+void HashSetEnumerator::trace(Tracer &tracer) {
+    tracer.visit(_set);
+}
+
+SIF_NAMESPACE_END
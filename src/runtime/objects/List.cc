@@ -13,6 +13,7 @@
 
 #include "sif/Error.h"
 #include "sif/runtime/objects/List.h"
+#include "sif/runtime/Tracer.h"
 #include "sif/runtime/VirtualMachine.h"
 
 #include "utilities/hasher.h"
@@ -20,14 +21,173 @@
 
 SIF_NAMESPACE_BEGIN
 
-List::List(const std::vector<Value> &values) : _values(values) {}
+List::List(const std::vector<Value> &values)
+    : TrackedObject(Kind::List), _elements(Collect(values.begin(), values.end())) {}
 
-List::List(std::vector<Value> &&values) : _values(std::move(values)) {}
+List::List(std::vector<Value> &&values)
+    : TrackedObject(Kind::List), _elements(Collect(std::make_move_iterator(values.begin()),
+                                                   std::make_move_iterator(values.end()))) {}
 
-std::vector<Value> &List::values() { return _values; }
-const std::vector<Value> &List::values() const { return _values; }
+List::List(Elements elements) : TrackedObject(Kind::List), _elements(std::move(elements)) {}
 
-size_t List::size() const { return values().size(); }
+List::~List() {
+    if (_shared && shared()->owner == this) {
+        shared()->owner = nullptr;
+    }
+}
+
+List::Storage List::StorageFor(const Value &value) {
+    switch (value.type()) {
+    case Value::Type::Integer:
+        return Storage::Integers;
+    case Value::Type::Float:
+        return Storage::Floats;
+    default:
+        return Storage::Values;
+    }
+}
+
+template <typename T> static T Unboxed(const Value &value) {
+    if constexpr (std::is_same_v<T, Integer>) {
+        return value.asInteger();
+    } else if constexpr (std::is_same_v<T, Float>) {
+        return value.asFloat();
+    } else {
+        return value;
+    }
+}
+
+template <typename Elements> using ElementOf = typename std::decay_t<Elements>::value_type;
+
+// Matches the elements equal to a value, as Value::operator== would compare them boxed.
+template <typename T> static auto Equal(const Value &value) {
+    return [&value](const T &element) {
+        if constexpr (std::is_same_v<T, Integer>) {
+            if (value.isInteger()) {
+                return element == value.asInteger();
+            }
+            return value.isFloat() && static_cast<Float>(element) == value.asFloat();
+        } else if constexpr (std::is_same_v<T, Float>) {
+            return value.isNumber() && element == value.castFloat();
+        } else {
+            return element == value;
+        }
+    };
+}
+
+void List::accommodate(const Value &value) {
+    auto storage = StorageFor(value);
+    if (storage == this->storage()) {
+        return;
+    }
+    if (empty()) {
+        detach();
+        switch (storage) {
+        case Storage::Values:
+            _elements.emplace<Vector<Value>>();
+            break;
+        case Storage::Integers:
+            _elements.emplace<Vector<Integer>>();
+            break;
+        case Storage::Floats:
+            _elements.emplace<Vector<Float>>();
+            break;
+        }
+        return;
+    }
+    values();
+}
+
+List::Vector<Value> &List::values() {
+    detach();
+    _hash.reset();
+    if (auto values = std::get_if<Vector<Value>>(&_elements)) {
+        return *values;
+    }
+    Vector<Value> values;
+    visit([&](const auto &elements) { values.assign(elements.begin(), elements.end()); });
+    return _elements.emplace<Vector<Value>>(std::move(values));
+}
+
+size_t List::size() const {
+    return visit([](const auto &elements) { return elements.size(); });
+}
+
+Value List::at(size_t index) const {
+    return visit([index](const auto &elements) { return Value(elements[index]); });
+}
+
+void List::set(size_t index, Value value) {
+    accommodate(value);
+    visit([&](auto &elements) {
+        elements[index] = Unboxed<ElementOf<decltype(elements)>>(value);
+    });
+}
+
+void List::append(Value value) {
+    accommodate(value);
+    visit([&](auto &elements) {
+        elements.push_back(Unboxed<ElementOf<decltype(elements)>>(value));
+    });
+}
+
+void List::insert(size_t index, Value value) {
+    accommodate(value);
+    visit([&](auto &elements) {
+        elements.insert(elements.begin() + index, Unboxed<ElementOf<decltype(elements)>>(value));
+    });
+}
+
+void List::insert(size_t index, const List &list) {
+    _hash.reset();
+    if (list.empty()) {
+        return;
+    }
+    if (empty()) {
+        detach();
+        _elements = list.elements();
+        return;
+    }
+    if (storage() != list.storage()) {
+        auto &values = this->values();
+        list.visit([&](const auto &other) {
+            values.insert(values.begin() + index, other.begin(), other.end());
+        });
+        return;
+    }
+    visit([&](auto &elements) {
+        const auto &other = std::get<std::decay_t<decltype(elements)>>(list.elements());
+        elements.insert(elements.begin() + index, other.begin(), other.end());
+    });
+}
+
+void List::erase(size_t begin, size_t end) {
+    visit([&](auto &elements) {
+        elements.erase(elements.begin() + begin, elements.begin() + end);
+    });
+}
+
+List::Elements List::slice(size_t begin, size_t end) const {
+    return visit([&](const auto &elements) -> Elements {
+        return std::decay_t<decltype(elements)>(elements.begin() + begin, elements.begin() + end);
+    });
+}
+
+size_t List::reservedBytes() const {
+    if (_shared) {
+        if (!shared()->owner) {
+            shared()->owner = this;
+        } else if (shared()->owner != this) {
+            return 0;
+        }
+    }
+    return visit([](const auto &elements) -> size_t {
+        if (elements.isInline()) {
+            return 0;
+        }
+        return elements.capacity() * sizeof(ElementOf<decltype(elements)>);
+    });
+}
 
 std::string List::typeName() const { return "list"; }
 
@@ -44,15 +204,14 @@ std::string List::description(Set<const Object *> &visited) const {
 
     std::ostringstream ss;
     ss << "[";
-    auto it = _values.begin();
-    while (it != _values.end()) {
-        if (it->isObject()) {
-            ss << it->asObject()->description(visited);
+    for (size_t i = 0; i < size(); i++) {
+        auto value = at(i);
+        if (value.isObject()) {
+            ss << value.asObject()->description(visited);
         } else {
-            ss << it->description();
+            ss << value.description();
         }
-        it++;
-        if (it != _values.end()) {
+        if (i + 1 < size()) {
             ss << ", ";
         }
     }
@@ -64,96 +223,147 @@ std::string List::description(Set<const Object *> &visited) const {
 }
 
 bool List::equals(Strong<Object> object) const {
-    if (const auto &list = Cast<List>(object)) {
-        return _values == list->_values;
+    auto list = ObjectCast<List>(object.get());
+    if (!list || list->size() != size()) {
+        return false;
+    }
+    if (list->storage() == storage()) {
+        return elements() == list->elements();
     }
-    return false;
+    for (size_t i = 0; i < size(); i++) {
+        if (!(at(i) == list->at(i))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 size_t List::hash() const {
+    if (_hash) {
+        return _hash.value();
+    }
     hasher h;
-    for (const auto &v : _values) {
-        h.hash(v, Value::Hash());
+    bool cacheable = true;
+    visit([&](const auto &elements) {
+        for (const auto &element : elements) {
+            Value value(element);
+            cacheable = cacheable && !value.isObject();
+            h.hash(value, Value::Hash());
+        }
+    });
+    if (cacheable) {
+        _hash = h.value();
     }
     return h.value();
 }
 
 void List::replaceAll(const Value &searchValue, const Value &replacementValue) {
-    auto result = std::find(_values.begin(), _values.end(), searchValue);
-    while (result != _values.end()) {
-        *result = replacementValue;
-        result = std::find(result + 1, _values.end(), searchValue);
+    for (size_t i = 0; i < size(); i++) {
+        if (at(i) == searchValue) {
+            set(i, replacementValue);
+        }
     }
 }
 
 void List::replaceFirst(const Value &searchValue, const Value &replacementValue) {
-    auto result = std::find(_values.begin(), _values.end(), searchValue);
-    if (result != _values.end()) {
-        *result = replacementValue;
+    if (auto index = findFirst(searchValue)) {
+        set(index.value(), replacementValue);
     }
 }
 
 void List::replaceLast(const Value &searchValue, const Value &replacementValue) {
-    auto result = std::find(_values.rbegin(), _values.rend(), searchValue);
-    if (result != _values.rend()) {
-        *result = replacementValue;
+    if (auto index = findLast(searchValue)) {
+        set(index.value(), replacementValue);
     }
 }
 
-bool List::contains(const Value &value) const {
-    return std::find(_values.begin(), _values.end(), value) != _values.end();
-}
+bool List::contains(const Value &value) const { return findFirst(value).has_value(); }
 
-bool List::startsWith(const Value &value) const {
-    return _values.size() > 0 && _values.front() == value;
-}
+bool List::startsWith(const Value &value) const { return !empty() && at(0) == value; }
 
-bool List::endsWith(const Value &value) const {
-    return _values.size() > 0 && _values.back() == value;
-}
+bool List::endsWith(const Value &value) const { return !empty() && at(size() - 1) == value; }
 
 Optional<Integer> List::findFirst(const Value &value) const {
-    auto result = std::find(_values.begin(), _values.end(), value);
-    if (result == _values.end()) {
-        return None;
-    }
-    return result - _values.begin();
+    return visit([&](const auto &elements) -> Optional<Integer> {
+        using T = ElementOf<decltype(elements)>;
+        auto result = std::find_if(elements.begin(), elements.end(), Equal<T>(value));
+        if (result == elements.end()) {
+            return None;
+        }
+        return result - elements.begin();
+    });
 }
 
 Optional<Integer> List::findLast(const Value &value) const {
-    auto result = std::find(_values.rbegin(), _values.rend(), value);
-    if (result == _values.rend()) {
-        return None;
+    return visit([&](const auto &elements) -> Optional<Integer> {
+        using T = ElementOf<decltype(elements)>;
+        auto result = std::find_if(elements.rbegin(), elements.rend(), Equal<T>(value));
+        if (result == elements.rend()) {
+            return None;
+        }
+        return result.base() - elements.begin() - 1;
+    });
+}
+
+void List::detach() {
+    acyclic = false;
+    if (!_shared) {
+        return;
+    }
+    if (_shared->references() == 1) {
+        _elements = std::move(shared()->elements);
+    } else {
+        _elements = shared()->elements;
+        if (shared()->owner == this) {
+            shared()->owner = nullptr;
+        }
     }
-    return result.base() - _values.begin() - 1;
+    _shared.reset();
 }
 
-Strong<Object> List::copy(VirtualMachine &vm) const { return vm.make<List>(values()); }
+Strong<Object> List::copy(VirtualMachine &vm) const {
+    auto list = vm.make<List>();
+    // Short lists are cheaper to copy than to share. Lists the machine does not track, such as
+    // bytecode constants, are copied too: they may be used by other machines, and outlive the
+    // heap the shared elements would be allocated from.
+    if (!_shared && tracker == &vm && reservedBytes() > 0) {
+        _shared = vm.make<Shared>(std::move(_elements), this);
+        _elements = Vector<Value>();
+    }
+    if (_shared) {
+        list->_shared = _shared;
+    } else {
+        list->_elements = _elements;
+    }
+    list->_hash = _hash;
+    return list;
+}
 
 Value List::enumerator(Value self) const { return MakeStrong<ListEnumerator>(self.as<List>()); }
 
 Result<Value, Error> List::subscript(VirtualMachine &vm, SourceLocation location,
                                      const Value &value) const {
     if (auto range = value.as<Range>()) {
-        auto start = _values.begin() + range->start();
-        auto end = _values.begin() + range->end() + (range->closed() ? 1 : 0);
-        if (start < _values.begin())
-            start = _values.begin();
-        if (start > _values.end())
-            start = _values.end() - 1;
-        if (end < _values.begin())
-            end = _values.begin();
-        if (end > _values.end())
-            end = _values.end();
-        return vm.make<List>(std::vector(start, end));
+        auto count = static_cast<Integer>(size());
+        auto start = range->start();
+        auto end = range->end() + (range->closed() ? 1 : 0);
+        if (start < 0)
+            start = 0;
+        if (start > count)
+            start = count - 1;
+        if (end < 0)
+            end = 0;
+        if (end > count)
+            end = count;
+        return vm.make<List>(slice(start, end));
     }
     if (value.isInteger()) {
         auto index = value.asInteger();
-        if (index >= static_cast<int>(_values.size()) ||
-            static_cast<int>(_values.size()) + index < 0) {
+        auto count = static_cast<Integer>(size());
+        if (index >= count || count + index < 0) {
             return Fail(Error(location, Errors::ListIndexOutOfBounds));
         }
-        return Value(_values[index < 0 ? _values.size() + index : index]);
+        return at(index < 0 ? count + index : index);
     }
     return Fail(Error(location, "expected an integer or range"));
 }
@@ -161,57 +371,71 @@ Result<Value, Error> List::subscript(VirtualMachine &vm, SourceLocation location
 Result<Value, Error> List::setSubscript(VirtualMachine &vm, SourceLocation location,
                                         const Value &key, Value value) {
     if (auto range = key.as<Range>()) {
-        _values.erase(_values.begin() + range->start(),
-                      _values.begin() + range->end() + (range->closed() ? 1 : 0));
+        erase(range->start(), range->end() + (range->closed() ? 1 : 0));
         if (auto list = value.as<List>()) {
-            _values.insert(_values.begin(), list->values().begin(), list->values().end());
+            insert(0, *list);
         } else {
-            _values.insert(_values.begin() + range->start(), value);
+            insert(range->start(), value);
         }
     }
     if (key.isInteger()) {
         auto index = key.asInteger();
-        if (index >= static_cast<Integer>(_values.size()) ||
-            static_cast<Integer>(_values.size()) + index < 0) {
+        auto count = static_cast<Integer>(size());
+        if (index >= count || count + index < 0) {
             return Fail(Error(location, Errors::ListIndexOutOfBounds));
         }
-        _values[index < 0 ? _values.size() + index : index] = value;
+        set(index < 0 ? count + index : index, value);
     }
     vm.notifyContainerMutation(this);
     return Value();
 }
 
-void List::trace(const std::function<void(Strong<Object> &)> &visitor) {
-    for (auto &value : _values) {
-        if (value.isObject()) {
-            visitor(value.reference());
+static void TraceElements(List::Elements &elements, Tracer &tracer) {
+    if (auto values = std::get_if<List::Vector<Value>>(&elements)) {
+        for (auto &value : *values) {
+            if (value.isObject()) {
+                tracer.visit(value.reference());
+            }
         }
     }
 }
 
+void List::trace(Tracer &tracer) {
+    // Shared elements are traced once through the object that holds them, however many lists
+    // share them.
+    if (_shared) {
+        tracer.visit(_shared);
+    } else {
+        TraceElements(_elements, tracer);
+    }
+}
+
+void List::Shared::trace(Tracer &tracer) {
+    TraceElements(elements, tracer);
+}
+
 #pragma mark - ListEnumerator
 
-ListEnumerator::ListEnumerator(Strong<List> list) : _list(list), _index(0) {}
+ListEnumerator::ListEnumerator(Strong<List> list)
+    : TrackedObject(Kind::ListEnumerator), _list(list), _index(0) {}
 
 List *ListEnumerator::ptr() const { return static_cast<List *>(_list.get()); }
 
 Value ListEnumerator::enumerate() {
-    if (_index >= ptr()->values().size()) {
+    if (_index >= ptr()->size()) {
         return Value();
     }
-    auto value = ptr()->values()[_index];
-    _index++;
-    return value;
+    return ptr()->at(_index++);
 }
 
-bool ListEnumerator::isAtEnd() { return ptr()->values().size() == _index; }
+bool ListEnumerator::isAtEnd() { return ptr()->size() == _index; }
 
 std::string ListEnumerator::typeName() const { return "ListEnumerator"; }
 
 std::string ListEnumerator::description() const { return Concat("E(", ptr()->description(), ")"); }
 
-void ListEnumerator::trace(const std::function<void(Strong<Object> &)> &visitor) {
-    visitor(_list);
+void ListEnumerator::trace(Tracer &tracer) {
+    tracer.visit(_list);
 }
 
 SIF_NAMESPACE_END
@@ -15,7 +15,7 @@
 
 SIF_NAMESPACE_BEGIN
 
-Native::Native(const Native::Callable &callable) : _callable(callable) {}
+Native::Native(const Native::Callable &callable) : Object(Kind::Native), _callable(callable) {}
 
 const Native::Callable &Native::callable() const { return _callable; }
 
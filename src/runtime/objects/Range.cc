@@ -18,7 +18,8 @@
 
 SIF_NAMESPACE_BEGIN
 
-Range::Range(Integer start, Integer end, bool closed) : _start(start), _end(end), _closed(closed) {}
+Range::Range(Integer start, Integer end, bool closed)
+    : Object(Kind::Range), _start(start), _end(end), _closed(closed) {}
 
 Integer Range::start() const { return _start; }
 
@@ -35,7 +36,7 @@ std::string Range::description() const {
 }
 
 bool Range::equals(Strong<Object> object) const {
-    if (const auto &range = Cast<Range>(object)) {
+    if (auto range = ObjectCast<Range>(object.get())) {
         return _start == range->start() && _end == range->end() && _closed == range->closed();
     }
     return false;
@@ -92,7 +93,8 @@ Result<Value, Error> Range::setSubscript(VirtualMachine &vm, SourceLocation loca
 
 #pragma mark - RangeEnumerator
 
-RangeEnumerator::RangeEnumerator(Strong<Range> range) : _range(range), _index(0) {}
+RangeEnumerator::RangeEnumerator(Strong<Range> range)
+    : Object(Kind::RangeEnumerator), _range(range), _index(0) {}
 
 Value RangeEnumerator::enumerate() {
     if (_index >= _range->size()) {
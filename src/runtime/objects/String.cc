@@ -21,9 +21,12 @@
 
 SIF_NAMESPACE_BEGIN
 
-String::String(const std::string &string) : _string(string) {}
+String::String(const std::string &string) : Object(Kind::String), _string(string) {}
 
-std::string &String::string() { return _string; }
+std::string &String::string() {
+    _hash.reset();
+    return _string;
+}
 
 const std::string &String::string() const { return _string; }
 
@@ -54,13 +57,19 @@ std::string String::description() const { return Quoted(_string); }
 std::string String::debugDescription() const { return Quoted(escaped_string_from_string(_string)); }
 
 bool String::equals(Strong<Object> object) const {
-    if (const auto &string = Cast<String>(object)) {
+    if (auto string = ObjectCast<String>(object.get())) {
         return _string == string->_string;
     }
     return false;
 }
 
-size_t String::hash() const { return std::hash<std::string>{}(_string); }
+// The empty string hashes like empty, which it equals.
+size_t String::hash() const {
+    if (!_hash) {
+        _hash = _string.empty() ? 0 : std::hash<std::string>{}(_string);
+    }
+    return _hash.value();
+}
 
 Strong<Object> String::copy(VirtualMachine &vm) const { return vm.make<String>(_string); }
 
@@ -141,6 +150,7 @@ Result<Value, Error> String::setSubscript(VirtualMachine &vm, SourceLocation loc
                                           const Value &key, Value value) {
     if (auto range = key.as<Range>()) {
         if (auto string = value.as<String>()) {
+            _hash.reset();
             _string.replace(_string.begin() + range->start(),
                             _string.begin() + range->end() + (range->closed() ? 1 : 0),
                             string->string());
@@ -150,6 +160,7 @@ Result<Value, Error> String::setSubscript(VirtualMachine &vm, SourceLocation loc
     }
     if (key.isInteger()) {
         if (auto string = value.as<String>()) {
+            _hash.reset();
             _string.replace(_string.begin() + key.asInteger(),
                             _string.begin() + key.asInteger() + 1, string->string());
             return Value();
@@ -181,7 +192,8 @@ Result<Value, Error> String::castFloat() const {
 
 #pragma mark - StringEnumerator
 
-StringEnumerator::StringEnumerator(Strong<String> string) : _string(string), _index(0) {}
+StringEnumerator::StringEnumerator(Strong<String> string)
+    : Object(Kind::StringEnumerator), _string(string), _index(0) {}
 
 Value StringEnumerator::enumerate() {
     if (_index >= _string->string().size()) {
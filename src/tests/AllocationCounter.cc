@@ -0,0 +1,93 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "tests/AllocationCounter.h"
+#include "tests/TestSuite.h"
+
+#include <sif/compiler/Compiler.h>
+#include <sif/compiler/Parser.h>
+#include <sif/compiler/Reader.h>
+#include <sif/compiler/Reporter.h>
+#include <sif/compiler/Scanner.h>
+#include <sif/compiler/Signature.h>
+#include <sif/runtime/ModuleLoader.h>
+#include <sif/runtime/VirtualMachine.h>
+#include <sif/runtime/objects/Native.h>
+
+#include <cstdlib>
+#include <new>
+#include <sstream>
+
+SIF_NAMESPACE_BEGIN
+
+size_t AllocationCounter::count = 0;
+
+static size_t AllocationsFor(TestSuite &suite, const Strong<Bytecode> &bytecode,
+                             Integer iterations) {
+    VirtualMachine vm;
+    vm.addGlobal("iterations", MakeStrong<Native>([iterations](const NativeCallContext &) {
+                     return Result<Value, Error>(Value(iterations));
+                 }));
+    vm.addGlobal("touch {}", MakeStrong<Native>([](const NativeCallContext &context) {
+                     return Result<Value, Error>(context.arguments[0]);
+                 }));
+    auto before = AllocationCounter::count;
+    auto result = vm.execute(bytecode);
+    auto allocations = AllocationCounter::count - before;
+    ASSERT_TRUE(result.has_value());
+    return allocations;
+}
+
+size_t AllocationGrowth(TestSuite &suite, const std::string &source) {
+    std::ostringstream err;
+    Scanner scanner;
+    StringReader reader(source);
+    ModuleLoader loader;
+    IOReporter reporter(err);
+    ParserConfig parserConfig{scanner, reader, loader, reporter};
+    Parser parser(parserConfig);
+    parser.declare(Signature::Make("iterations").value());
+    parser.declare(Signature::Make("touch {}").value());
+    auto statement = parser.statement();
+    ASSERT_FALSE(parser.failed()) << err.str();
+    if (parser.failed()) {
+        return 0;
+    }
+    Compiler compiler(CompilerConfig{loader, reporter, false, true});
+    auto bytecode = compiler.compile(*statement);
+    ASSERT_TRUE(bytecode);
+    if (!bytecode) {
+        return 0;
+    }
+    return AllocationsFor(suite, bytecode, 1000) - AllocationsFor(suite, bytecode, 10);
+}
+
+SIF_NAMESPACE_END
+
+void *operator new(size_t size) {
+    sif::AllocationCounter::count++;
+    if (auto pointer = std::malloc(size ? size : 1)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { std::free(pointer); }
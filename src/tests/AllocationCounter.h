@@ -0,0 +1,37 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#pragma once
+
+#include <sif/Common.h>
+
+#include <string>
+
+struct TestSuite;
+
+SIF_NAMESPACE_BEGIN
+
+// Counts calls to the global operator new made anywhere in the test binary.
+struct AllocationCounter {
+    static size_t count;
+};
+
+// Returns how many more allocations running a script for 1000 iterations makes than running it for
+// 10. The script reads the count from the iterations global, and may call touch {}, a native that
+// returns its argument.
+size_t AllocationGrowth(TestSuite &suite, const std::string &source);
+
+SIF_NAMESPACE_END
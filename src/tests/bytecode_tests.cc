@@ -0,0 +1,280 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "tests/TestSuite.h"
+
+#include <sif/compiler/Bytecode.h>
+#include <sif/compiler/Compiler.h>
+#include <sif/compiler/Parser.h>
+#include <sif/compiler/Reader.h>
+#include <sif/compiler/Reporter.h>
+#include <sif/compiler/Scanner.h>
+#include <sif/compiler/Signature.h>
+#include <sif/runtime/ModuleLoader.h>
+#include <sif/runtime/VirtualMachine.h>
+#include <sif/runtime/objects/List.h>
+#include <sif/runtime/objects/Native.h>
+#include <sif/runtime/objects/String.h>
+
+#include <climits>
+#include <sstream>
+
+using namespace sif;
+
+TEST_CASE(Bytecode, InternsConstantsByTypeAndValue) {
+    Bytecode bytecode;
+    auto integer = bytecode.addConstant(Value(1));
+    auto floating = bytecode.addConstant(Value(1.0));
+    auto truth = bytecode.addConstant(Value(true));
+    auto string = bytecode.addConstant(MakeStrong<String>("1"));
+    auto empty = bytecode.addConstant(Value());
+    auto emptyString = bytecode.addConstant(MakeStrong<String>(""));
+
+    ASSERT_EQ(bytecode.constants().size(), 6u);
+    ASSERT_EQ(bytecode.addConstant(Value(1)), integer);
+    ASSERT_EQ(bytecode.addConstant(Value(1.0)), floating);
+    ASSERT_EQ(bytecode.addConstant(Value(true)), truth);
+    ASSERT_EQ(bytecode.addConstant(MakeStrong<String>("1")), string);
+    ASSERT_EQ(bytecode.addConstant(Value()), empty);
+    ASSERT_EQ(bytecode.addConstant(MakeStrong<String>("")), emptyString);
+    ASSERT_EQ(bytecode.constants().size(), 6u);
+}
+
+TEST_CASE(Bytecode, InternsContainersByIdentity) {
+    Bytecode bytecode;
+    auto list = MakeStrong<List>();
+    auto index = bytecode.addConstant(list);
+    ASSERT_EQ(bytecode.addConstant(list), index);
+    ASSERT_NEQ(bytecode.addConstant(MakeStrong<List>()), index);
+}
+
+TEST_CASE(Bytecode, LimitsConstantCount) {
+    Bytecode bytecode;
+    for (Integer i = 0; i < USHRT_MAX; i++) {
+        bytecode.addConstant(Value(i));
+    }
+    ASSERT_THROWS(bytecode.addConstant(Value(Integer(USHRT_MAX))));
+    ASSERT_EQ(bytecode.addConstant(Value(Integer(USHRT_MAX - 1))), USHRT_MAX - 1);
+}
+
+TEST_CASE(Bytecode, DecodesSourceLocations) {
+    Bytecode bytecode;
+    std::vector<SourceLocation> expected;
+    for (unsigned int i = 0; i < 1000; i++) {
+        // Revisit earlier lines now and then, as loops and implicit returns do.
+        SourceLocation location{i % 7, i % 5 == 0 ? 0 : i / 3, i * 11 % 997};
+        auto start = i % 4 == 0 ? bytecode.add(location, Opcode::Pop)
+                                : bytecode.add(location, Opcode::GetLocal, i);
+        expected.resize(bytecode.code().size(), location);
+        ASSERT_EQ(start + InstructionLength(bytecode.code()[start]), expected.size());
+    }
+    for (auto it = bytecode.code().begin(); it != bytecode.code().end(); it++) {
+        ASSERT_TRUE(bytecode.location(it) == expected[it - bytecode.code().begin()]);
+    }
+}
+
+TEST_CASE(Bytecode, StoresArgumentRangesPerCall) {
+    Bytecode bytecode;
+    SourceRange first{{1, 0, 1}, {2, 0, 2}};
+    SourceRange second{{3, 1, 9}, {4, 1, 10}};
+    auto call = bytecode.add(SourceLocation(), Opcode::Call, 1);
+    bytecode.addArgumentRanges(call, {first, second});
+    auto other = bytecode.add(SourceLocation(), Opcode::Call, 0);
+    auto last = bytecode.add(SourceLocation(), Opcode::Call, 1);
+    bytecode.addArgumentRanges(last, {second});
+
+    ASSERT_TRUE(bytecode.argumentRanges(call) == std::vector<SourceRange>({first, second}));
+    ASSERT_TRUE(bytecode.argumentRanges(other).empty());
+    ASSERT_TRUE(bytecode.argumentRanges(last) == std::vector<SourceRange>({second}));
+}
+
+static Strong<Bytecode> Compile(const std::string &source,
+                                const std::vector<std::string> &signatures) {
+    std::ostringstream err;
+    Scanner scanner;
+    StringReader reader(source);
+    ModuleLoader loader;
+    IOReporter reporter(err);
+    ParserConfig parserConfig{scanner, reader, loader, reporter};
+    Parser parser(parserConfig);
+    for (const auto &signature : signatures) {
+        parser.declare(Signature::Make(signature).value());
+    }
+    auto statement = parser.statement();
+    if (parser.failed()) {
+        return nullptr;
+    }
+    CompilerConfig config{loader, reporter, false, true};
+    Compiler compiler(config);
+    return compiler.compile(*statement);
+}
+
+static std::vector<Opcode> Opcodes(const Bytecode &bytecode) {
+    std::vector<Opcode> opcodes;
+    const auto &code = bytecode.code();
+    for (size_t i = 0; i < code.size(); i += InstructionLength(code[i])) {
+        opcodes.push_back(code[i]);
+    }
+    return opcodes;
+}
+
+static std::string Disassemble(const Bytecode &bytecode) {
+    std::ostringstream out;
+    bytecode.printWithoutSourceLocations(out);
+    return out.str();
+}
+
+TEST_CASE(Bytecode, FusesInstructionPairs) {
+    Bytecode bytecode;
+    SourceLocation location;
+    bytecode.add(location, Opcode::GetLocal, 1);
+    bytecode.add(location, Opcode::GetLocal, 2);
+    bytecode.add(location, Opcode::GetLocal, 1);
+    bytecode.add(location, Opcode::Short, 3);
+    bytecode.add(location, Opcode::JumpIfFalse, 0);
+    bytecode.add(location, Opcode::Pop);
+    bytecode.add(location, Opcode::Call, 0);
+    bytecode.add(location, Opcode::SetIt);
+    bytecode.add(location, Opcode::Enumerate);
+    bytecode.add(location, Opcode::UnpackList, 2);
+    // An operand that reads as a GetLocal is not mistaken for an instruction.
+    bytecode.add(location, Opcode::GetLocal, static_cast<uint16_t>(Opcode::GetLocal));
+    bytecode.add(location, Opcode::Pop);
+    bytecode.add(location, Opcode::List, 2);
+    bytecode.add(location, Opcode::Return);
+    bytecode.fuseSuperinstructions();
+
+    std::vector<Opcode> expected{
+        Opcode::GetLocalGetLocal,
+        Opcode::GetLocalGetLocal,
+        Opcode::GetLocalShort,
+        Opcode::Short,
+        Opcode::JumpIfFalsePop,
+        Opcode::Pop,
+        Opcode::CallSetIt,
+        Opcode::SetIt,
+        Opcode::EnumerateUnpackList,
+        Opcode::UnpackList,
+        Opcode::GetLocal,
+        Opcode::Pop,
+        Opcode::ListReturn,
+        Opcode::Return,
+    };
+    ASSERT_TRUE(Opcodes(bytecode) == expected);
+}
+
+TEST_CASE(Bytecode, DisassemblesFusedInstructions) {
+    Bytecode bytecode;
+    SourceLocation location;
+    bytecode.add(location, Opcode::GetLocal, 1);
+    bytecode.add(location, Opcode::GetLocal, 2);
+    bytecode.add(location, Opcode::GetLocal, 1);
+    bytecode.add(location, Opcode::Short, 3);
+    auto jump = bytecode.add(location, Opcode::JumpIfFalse, 0);
+    bytecode.add(location, Opcode::Pop);
+    bytecode.add(location, Opcode::Call, 1);
+    bytecode.add(location, Opcode::SetIt);
+    bytecode.patchRelativeJump(jump);
+    bytecode.add(location, Opcode::List, 2);
+    bytecode.add(location, Opcode::Return);
+    bytecode.fuseSuperinstructions();
+
+    ASSERT_EQ(Disassemble(bytecode), "===\n"
+                                     "0000 GetLocalGetLocal 1\n"
+                                     "0003 GetLocalGetLocal 2\n"
+                                     "0006 GetLocalShort 1\n"
+                                     "0009 Short 3\n"
+                                     "0012 JumpIfFalsePop 0020\n"
+                                     "0015 Pop\n"
+                                     "0016 CallSetIt 1\n"
+                                     "0019 SetIt\n"
+                                     "0020 ListReturn 2\n"
+                                     "0023 Return\n");
+}
+
+TEST_CASE(Bytecode, RunsJumpsToTheSecondInstructionOfAPair) {
+    auto bytecode = MakeStrong<Bytecode>();
+    SourceLocation location;
+    bytecode->add(location, Opcode::Short, 7);
+    bytecode->add(location, Opcode::Short, 9);
+    auto jump = bytecode->add(location, Opcode::Jump, 0);
+    bytecode->add(location, Opcode::GetLocal, 1);
+    bytecode->patchRelativeJump(jump);
+    bytecode->add(location, Opcode::GetLocal, 2);
+    bytecode->add(location, Opcode::List, 3);
+    bytecode->add(location, Opcode::Return);
+    bytecode->fuseSuperinstructions();
+    ASSERT_EQ(bytecode->code()[9], Opcode::GetLocalGetLocal);
+
+    VirtualMachine vm;
+    auto result = vm.execute(bytecode);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result.value().toString(), "[7, 9, 9]");
+}
+
+TEST_CASE(Bytecode, RunsJumpIfFalsePopOnBothBranches) {
+    for (auto condition : {true, false}) {
+        auto bytecode = MakeStrong<Bytecode>();
+        SourceLocation location;
+        bytecode->add(location, Opcode::Short, 5);
+        bytecode->add(location, condition ? Opcode::True : Opcode::False);
+        auto jump = bytecode->add(location, Opcode::JumpIfFalse, 0);
+        bytecode->add(location, Opcode::Pop);
+        bytecode->add(location, Opcode::Short, 1);
+        bytecode->add(location, Opcode::List, 2);
+        bytecode->add(location, Opcode::Return);
+        bytecode->patchRelativeJump(jump);
+        bytecode->add(location, Opcode::Pop);
+        bytecode->add(location, Opcode::Short, 2);
+        bytecode->add(location, Opcode::List, 2);
+        bytecode->add(location, Opcode::Return);
+        bytecode->fuseSuperinstructions();
+        ASSERT_EQ(bytecode->code()[4], Opcode::JumpIfFalsePop);
+
+        VirtualMachine vm;
+        auto result = vm.execute(bytecode);
+        ASSERT_TRUE(result.has_value());
+        ASSERT_EQ(result.value().toString(), condition ? "[5, 1]" : "[5, 2]");
+    }
+}
+
+TEST_CASE(Bytecode, SetsItAfterFusedCalls) {
+    auto native = MakeStrong<Native>([](const NativeCallContext &context) -> Result<Value, Error> {
+        return Value(context.arguments[0].asInteger() * 2);
+    });
+
+    auto nativeCall = Compile("double 21\nit", {"double {}"});
+    ASSERT_TRUE(nativeCall);
+    ASSERT_TRUE(Disassemble(*nativeCall).find("CallSetIt 1") != std::string::npos);
+    VirtualMachine vm;
+    vm.addGlobal("double {}", native);
+    auto result = vm.execute(nativeCall);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result.value().asInteger(), 42);
+
+    // The function sets its own it, which must not leak into the caller's.
+    auto functionCall = Compile("function halve {n}\n"
+                                "  double n\n"
+                                "  return n / 2\n"
+                                "end function\n"
+                                "halve 8\n"
+                                "it",
+                                {"double {}"});
+    ASSERT_TRUE(functionCall);
+    result = vm.execute(functionCall);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result.value().castFloat(), 4.0);
+}
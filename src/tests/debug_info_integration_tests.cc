@@ -79,7 +79,7 @@ TEST_CASE(DebugInfoIntegration, BytecodeHasArgumentRanges) {
     auto codeWithoutDebug = bytecodeWithoutDebug->code();
 
     for (size_t i = 0; i < codeWithDebug.size(); i++) {
-        if (codeWithDebug[i] == Opcode::Call) {
+        if (codeWithDebug[i] == Opcode::Call || codeWithDebug[i] == Opcode::CallSetIt) {
             auto ranges = bytecodeWithDebug->argumentRanges(i);
             if (!ranges.empty()) {
                 foundRangesWithDebug = true;
@@ -89,7 +89,7 @@ TEST_CASE(DebugInfoIntegration, BytecodeHasArgumentRanges) {
     }
 
     for (size_t i = 0; i < codeWithoutDebug.size(); i++) {
-        if (codeWithoutDebug[i] == Opcode::Call) {
+        if (codeWithoutDebug[i] == Opcode::Call || codeWithoutDebug[i] == Opcode::CallSetIt) {
             auto ranges = bytecodeWithoutDebug->argumentRanges(i);
             if (!ranges.empty()) {
                 foundRangesWithoutDebug = true;
@@ -110,7 +110,7 @@ TEST_CASE(DebugInfoIntegration, SpecificArgumentRangeValidation) {
 
     auto code = bytecode->code();
     for (size_t i = 0; i < code.size(); i++) {
-        if (code[i] == Opcode::Call) {
+        if (code[i] == Opcode::Call || code[i] == Opcode::CallSetIt) {
             auto ranges = bytecode->argumentRanges(i);
             ASSERT_EQ(ranges.size(), 4);
 
@@ -130,7 +130,7 @@ TEST_CASE(DebugInfoIntegration, ArgumentRangeAccuracy) {
 
     auto code = bytecode->code();
     for (size_t i = 0; i < code.size(); i++) {
-        if (code[i] == Opcode::Call) {
+        if (code[i] == Opcode::Call || code[i] == Opcode::CallSetIt) {
             auto ranges = bytecode->argumentRanges(i);
             ASSERT_EQ(ranges.size(), 2);
 
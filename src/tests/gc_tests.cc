@@ -30,6 +30,7 @@
 #include <sif/runtime/objects/Dictionary.h>
 #include <sif/runtime/objects/List.h>
 #include <sif/runtime/objects/Native.h>
+#include <sif/runtime/objects/String.h>
 
 #include <random>
 #include <sstream>
@@ -79,6 +80,30 @@ TEST_CASE(GarbageCollector, ReportsLowerTrackedBytesAfterReclaim) {
     ASSERT_EQ(vm.currentTrackedBytes(), 0u);
 }
 
+TEST_CASE(GarbageCollector, ReleasesTrackedContainersInAnyOrder) {
+    VirtualMachine vm;
+    std::vector<Strong<List>> lists;
+    for (int i = 0; i < 8; ++i) {
+        lists.push_back(vm.make<List>(std::vector<Value>(i + 1, Value(i))));
+    }
+    auto bytes = vm.currentTrackedBytes();
+
+    // Release containers from the middle, the front and the back of the machine's list.
+    for (auto index : {3, 0, 7, 5}) {
+        lists[index].reset();
+    }
+    ASSERT_LT(vm.currentTrackedBytes(), bytes);
+
+    vm.serviceGarbageCollection();
+    for (auto &list : lists) {
+        if (list) {
+            ASSERT_EQ(list->tracker, &vm);
+            list.reset();
+        }
+    }
+    ASSERT_EQ(vm.currentTrackedBytes(), 0u);
+}
+
 TEST_CASE(GarbageCollector, MutationNotificationsIncreaseDebt) {
     VirtualMachineConfig config;
     config.initialGarbageCollectionThresholdBytes = 512;
@@ -262,3 +287,341 @@ collect garbage
     vm.serviceGarbageCollection();
     ASSERT_EQ(TrackingObject::count, 0);
 }
+
+TEST_CASE(GarbageCollector, PreservesContainersCollectedWhileBeingBuilt) {
+    const std::string source = R"(
+set pairs to [["x": 1, "y": 2], ["x": 3, "y": 4]]
+pairs
+)";
+
+    VirtualMachineConfig vmConfig;
+    vmConfig.initialGarbageCollectionThresholdBytes = 1;
+    vmConfig.minimumGarbageCollectionThresholdBytes = 1;
+    vmConfig.garbageCollectionGrowthFactor = 1.0;
+
+    std::ostringstream err;
+    Scanner scanner;
+    StringReader reader(source);
+    ModuleLoader loader;
+    IOReporter reporter(err);
+    ParserConfig parserConfig{scanner, reader, loader, reporter};
+    Parser parser(parserConfig);
+
+    auto statement = parser.statement();
+    ASSERT_FALSE(parser.failed());
+
+    auto compiler = MakeCompiler(loader, reporter);
+    auto bytecode = compiler.compile(*statement);
+    ASSERT_TRUE(bytecode);
+
+    VirtualMachine vm(vmConfig);
+    auto execResult = vm.execute(bytecode);
+    ASSERT_TRUE(execResult.has_value());
+    ASSERT_GT(vm.garbageCollectionCount(), 0u);
+
+    auto pairs = execResult.value().as<List>();
+    ASSERT_TRUE(pairs);
+    ASSERT_EQ(pairs->values().size(), 2u);
+    auto second = pairs->values()[1].as<Dictionary>();
+    ASSERT_TRUE(second);
+    ASSERT_EQ(second->values().size(), 2u);
+    ASSERT_EQ(second->values()[Value(std::string("y"))].asInteger(), 4);
+}
+
+TEST_CASE(GarbageCollector, ContainersMayOutliveTheMachine) {
+    Strong<List> list;
+    {
+        VirtualMachine vm;
+        list = vm.make<List>(std::vector<Value>{Value(vm.make<Dictionary>())});
+        ASSERT_EQ(list->tracker, &vm);
+    }
+    ASSERT_EQ(list->tracker, nullptr);
+    ASSERT_EQ(list->references(), 1u);
+    list.reset();
+}
+
+TEST_CASE(GarbageCollector, KeepsCollectorStateOutOfLeaves) {
+    ASSERT_LTE(sizeof(Object), sizeof(void *) + 8);
+    ASSERT_FALSE(Value(MakeStrong<String>("leaf")).as<TrackedObject>());
+    ASSERT_TRUE(Value(MakeStrong<List>()).as<TrackedObject>());
+}
+
+TEST_CASE(GarbageCollector, CollectsCyclesThroughSharedElements) {
+    VirtualMachine vm;
+    TrackingObject::count = 0;
+    {
+        auto list = vm.make<List>(std::vector<Value>(8, Value(vm.make<TrackingObject>())));
+        list->append(Value(list));
+        Value copy = list->copy(vm);
+        ASSERT_TRUE(list->isShared());
+    }
+    ASSERT_EQ(TrackingObject::count, 1);
+
+    vm.serviceGarbageCollection();
+    ASSERT_EQ(TrackingObject::count, 0);
+}
+
+TEST_CASE(GarbageCollector, CountsSharedElementsOnce) {
+    VirtualMachine vm;
+    auto list = vm.make<List>(std::vector<Value>(1000, Value(std::string("a"))));
+    vm.addGlobal("list", list);
+    vm.serviceGarbageCollection();
+    auto before = vm.currentTrackedBytes();
+
+    vm.addGlobal("copy", list->copy(vm));
+    vm.serviceGarbageCollection();
+    ASSERT_TRUE(list->isShared());
+    ASSERT_EQ(vm.currentTrackedBytes(), before + sizeof(List));
+
+    // The elements are counted for the copy once the list stops sharing them.
+    list->append(Value(1));
+    vm.addGlobal("list", Value());
+    list.reset();
+    vm.serviceGarbageCollection();
+    ASSERT_GT(vm.currentTrackedBytes(), 1000 * sizeof(Value));
+    ASSERT_LT(vm.currentTrackedBytes(), before + sizeof(List));
+}
+
+TEST_CASE(GarbageCollector, PreservesSharedElementsAcrossCollections) {
+    VirtualMachine vm;
+    TrackingObject::count = 0;
+    auto inner = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+    auto list = vm.make<List>(std::vector<Value>(8, Value(inner)));
+    vm.addGlobal("list", list);
+    vm.addGlobal("copy", list->copy(vm));
+    inner.reset();
+    list.reset();
+
+    vm.serviceGarbageCollection();
+    vm.serviceGarbageCollection();
+    ASSERT_EQ(TrackingObject::count, 1);
+}
+
+// Allocates more than the default collection threshold, so that the next safepoint collects.
+static void AllocateCollectionDebt(VirtualMachine &vm) {
+    vm.make<List>(std::vector<Value>(16 * 1024, Value(0)));
+}
+
+static VirtualMachineConfig YoungCollectionConfig() {
+    VirtualMachineConfig config;
+    config.automaticFullGarbageCollection = false;
+    return config;
+}
+
+TEST_CASE(GarbageCollector, CollectsYoungCyclesWithoutRoots) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    {
+        auto list = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+        list->append(Value(list));
+    }
+    ASSERT_EQ(TrackingObject::count, 1);
+
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.garbageCollectionCount(), 1u);
+    ASSERT_EQ(TrackingObject::count, 0);
+}
+
+TEST_CASE(GarbageCollector, PreservesYoungContainersReachableFromOldOnes) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    auto old = vm.make<List>();
+    vm.addGlobal("old", old);
+    vm.serviceGarbageCollection();
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+
+    // The old list is changed without telling the machine.
+    auto young = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+    old->append(Value(young));
+    young.reset();
+
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(TrackingObject::count, 1);
+    auto survivor = old->at(0).as<List>();
+    ASSERT_TRUE(survivor);
+    ASSERT_EQ(survivor->size(), 1u);
+}
+
+TEST_CASE(GarbageCollector, CollectsCyclesClosedThroughMutatedOldContainers) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    auto list = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+
+    list->append(Value(list));
+    vm.notifyContainerMutation(list.get());
+    ASSERT_EQ(vm.youngContainerCount(), 1u);
+    list.reset();
+
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(TrackingObject::count, 0);
+}
+
+TEST_CASE(GarbageCollector, ExaminesTheNurseryWithinThePauseBudget) {
+    auto config = YoungCollectionConfig();
+    config.youngGarbageCollectionBudget = 2;
+    VirtualMachine vm(config);
+    std::vector<Strong<List>> lists;
+    for (int i = 0; i < 5; ++i) {
+        lists.push_back(vm.make<List>());
+    }
+    ASSERT_EQ(vm.youngContainerCount(), 5u);
+
+    // The debt stays until the whole nursery has been examined, one slice per safepoint.
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.youngContainerCount(), 4u);
+    for (size_t expected : {2u, 0u}) {
+        vm.notifyContainerMutation(lists[0].get());
+        ASSERT_EQ(vm.youngContainerCount(), expected);
+    }
+    ASSERT_EQ(vm.bytesSinceLastCollection(), 0u);
+}
+
+TEST_CASE(GarbageCollector, CountsUntrackedObjectsAgainstThePauseBudget) {
+    auto config = YoungCollectionConfig();
+    config.youngGarbageCollectionBudget = 4;
+    VirtualMachine vm(config);
+    auto last = vm.make<List>();
+    auto lists =
+        vm.make<List>(std::vector<Value>{Value(MakeStrong<List>()), Value(MakeStrong<List>())});
+    auto strings = vm.make<List>(std::vector<Value>(8, Value(vm.make<String>("leaf"))));
+    ASSERT_EQ(vm.youngContainerCount(), 3u);
+
+    // Newer containers are examined first: the debt, the strings without their elements, and the
+    // untracked lists with their elements, which spends the budget before the last list.
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.garbageCollectionStatistics().lastCollection.objectsMarked, 4u);
+    ASSERT_EQ(vm.youngContainerCount(), 1u);
+}
+
+TEST_CASE(GarbageCollector, CollectsOldCyclesLeftByDecrements) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    auto list = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+    auto dictionary = vm.make<Dictionary>();
+    dictionary->values()[Value(1)] = Value(list);
+    list->append(Value(dictionary));
+    dictionary.reset();
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+
+    list.reset();
+    ASSERT_EQ(vm.youngContainerCount(), 1u);
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(TrackingObject::count, 0);
+}
+
+TEST_CASE(GarbageCollector, CollectsCyclesLeftByEnumeratorDecrements) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    auto list = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+    auto enumerator = list->enumerator(Value(list));
+    list->append(enumerator);
+    list.reset();
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+    ASSERT_EQ(TrackingObject::count, 1);
+
+    enumerator = Value();
+    ASSERT_EQ(vm.youngContainerCount(), 1u);
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(TrackingObject::count, 0);
+}
+
+TEST_CASE(GarbageCollector, DoesNotExamineLiveAcyclicContainersAgain) {
+    VirtualMachine vm(YoungCollectionConfig());
+    std::vector<Value> strings;
+    for (int i = 0; i < 10000; ++i) {
+        strings.push_back(Value(vm.make<String>(std::to_string(i))));
+    }
+    auto list = vm.make<List>(std::move(strings));
+    vm.addGlobal("list", list);
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+
+    // Dropping temporary references to the list, directly or through an enumerator, cannot leave
+    // a cycle, so it is not examined again.
+    {
+        auto temporary = list;
+    }
+    list->enumerator(Value(list));
+    ASSERT_EQ(vm.youngContainerCount(), 0u);
+
+    // A young container referring to it does not examine it either.
+    auto holder = vm.make<List>(std::vector<Value>{Value(list)});
+    AllocateCollectionDebt(vm);
+    ASSERT_EQ(vm.garbageCollectionStatistics().lastCollection.objectsMarked, 2u);
+
+    // Once it changes it may be part of a cycle.
+    list->append(Value(list));
+    {
+        auto temporary = list;
+    }
+    ASSERT_EQ(vm.youngContainerCount(), 1u);
+    list->erase(list->size() - 1, list->size());
+}
+
+TEST_CASE(GarbageCollector, ReportsCollectionStatistics) {
+    VirtualMachine vm(YoungCollectionConfig());
+    TrackingObject::count = 0;
+    {
+        auto list = vm.make<List>(std::vector<Value>{Value(vm.make<TrackingObject>())});
+        list->append(Value(list));
+    }
+    AllocateCollectionDebt(vm);
+
+    const auto &statistics = vm.garbageCollectionStatistics();
+    ASSERT_EQ(statistics.youngCollections, 1u);
+    ASSERT_EQ(statistics.fullCollections, 0u);
+    ASSERT_FALSE(statistics.lastCollection.full);
+    ASSERT_GTE(statistics.lastCollection.objectsFreed, 2u);
+    ASSERT_GT(statistics.lastCollection.bytesReclaimed, 0u);
+    ASSERT_GT(statistics.peakTrackedBytes, vm.currentTrackedBytes());
+
+    vm.addGlobal("list", vm.make<List>(std::vector<Value>{Value(vm.make<List>())}));
+    vm.serviceGarbageCollection();
+    ASSERT_EQ(statistics.fullCollections, 1u);
+    ASSERT_TRUE(statistics.lastCollection.full);
+    ASSERT_EQ(statistics.lastCollection.objectsMarked, 2u);
+    ASSERT_EQ(statistics.lastCollection.objectsFreed, 0u);
+
+    size_t pauses = 0;
+    for (auto count : statistics.pauseHistogram) {
+        pauses += count;
+    }
+    ASSERT_EQ(pauses, statistics.collections());
+    ASSERT_GTE(statistics.totalPause, statistics.maximumPause);
+    ASSERT_EQ(vm.liveContainerCount(), 2u);
+}
+
+TEST_CASE(GarbageCollector, MarksDeeplyNestedStructures) {
+    VirtualMachine vm;
+    TrackingObject::count = 0;
+    auto root = vm.make<List>();
+    vm.addGlobal("root", root);
+    auto current = root;
+    for (int depth = 0; depth < 1000; ++depth) {
+        auto next = vm.make<List>(std::vector<Value>{Value(vm.make<Dictionary>())});
+        current->append(Value(next));
+        current = next;
+    }
+    current->append(Value(vm.make<TrackingObject>()));
+    current.reset();
+
+    for (int iteration = 0; iteration < 4; ++iteration) {
+        vm.serviceGarbageCollection();
+        const auto &collection = vm.garbageCollectionStatistics().lastCollection;
+        ASSERT_EQ(collection.objectsMarked, 2002u);
+        ASSERT_EQ(collection.objectsFreed, 0u);
+    }
+    ASSERT_EQ(TrackingObject::count, 1);
+
+    // Close the chain into a cycle and drop it.
+    root->at(0).as<List>()->append(Value(root));
+    vm.addGlobal("root", Value());
+    root.reset();
+    vm.serviceGarbageCollection();
+    ASSERT_EQ(TrackingObject::count, 0);
+    ASSERT_EQ(vm.liveContainerCount(), 0u);
+}
@@ -51,7 +51,7 @@ static std::string gather(const std::string &source, const std::string &context)
     return ss.str();
 }
 
-TEST_CASE(TranscriptTests, All) {
+static void RunTranscripts(TestSuite &suite, bool registerInstructions) {
     auto currentPath = std::filesystem::current_path();
     for (auto pstr : suite.all_files_in("transcripts")) {
         auto path = std::filesystem::path(pstr);
@@ -83,6 +83,7 @@ TEST_CASE(TranscriptTests, All) {
         auto directoryPath = (suite.config.resourcesPath / path).parent_path();
         std::filesystem::current_path(currentPath / directoryPath);
         loader.config.searchPaths.push_back(std::filesystem::path("./"));
+        loader.config.registerInstructions = registerInstructions;
         ParserConfig config{scanner, reader, loader, reporter};
         Parser parser(config);
 
@@ -104,7 +105,9 @@ TEST_CASE(TranscriptTests, All) {
         if (!parser.failed()) {
             bool enableDebugInfo = source.find("# DEBUG_INFO: false") == std::string::npos;
 
-            Compiler compiler(CompilerConfig{loader, reporter, false, enableDebugInfo});
+            CompilerConfig compilerConfig{loader, reporter, false, enableDebugInfo};
+            compilerConfig.registerInstructions = registerInstructions;
+            Compiler compiler(compilerConfig);
             auto bytecode = compiler.compile(*statement);
             if (bytecode) {
                 VirtualMachine vm;
@@ -150,3 +153,7 @@ TEST_CASE(TranscriptTests, All) {
         std::filesystem::current_path(currentPath);
     }
 }
+
+TEST_CASE(TranscriptTests, All) { RunTranscripts(suite, false); }
+
+TEST_CASE(TranscriptTests, AllWithRegisterInstructions) { RunTranscripts(suite, true); }
@@ -0,0 +1,283 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "tests/TestSuite.h"
+#include "tests/TrackingObject.h"
+
+#include <sif/runtime/Value.h>
+#include <sif/runtime/VirtualMachine.h>
+#include <sif/runtime/modules/Core.h>
+#include <sif/runtime/objects/Dictionary.h>
+#include <sif/runtime/objects/HashSet.h>
+#include <sif/runtime/objects/List.h>
+#include <sif/runtime/objects/Native.h>
+#include <sif/runtime/objects/Range.h>
+#include <sif/runtime/objects/String.h>
+#include <sif/runtime/protocols/Castable.h>
+#include <sif/runtime/protocols/Copyable.h>
+#include <sif/runtime/protocols/Enumerable.h>
+#include <sif/runtime/protocols/Subscriptable.h>
+
+using namespace sif;
+
+TEST_CASE(Value, CastsToClassesByKind) {
+    Value list(MakeStrong<List>());
+    ASSERT_TRUE(list.as<List>());
+    ASSERT_TRUE(list.as<Object>());
+    ASSERT_FALSE(list.as<String>());
+    ASSERT_FALSE(list.as<Dictionary>());
+    ASSERT_FALSE(list.as<Enumerator>());
+    ASSERT_FALSE(Value(1).as<List>());
+
+    auto enumerator = list.as<List>()->enumerator(list);
+    ASSERT_TRUE(enumerator.as<Enumerator>());
+    ASSERT_TRUE(enumerator.as<ListEnumerator>());
+    ASSERT_FALSE(enumerator.as<RangeEnumerator>());
+}
+
+TEST_CASE(Value, CastsToProtocolsByKind) {
+    Value string(std::string("text"));
+    Value range(MakeStrong<Range>(0, 1, false));
+    Value dictionary(MakeStrong<Dictionary>());
+
+    ASSERT_EQ(string.as<Copyable>(), static_cast<Copyable *>(string.as<String>().get()));
+    ASSERT_EQ(string.as<NumberCastable>(),
+              static_cast<NumberCastable *>(string.as<String>().get()));
+    ASSERT_EQ(range.as<Subscriptable>(), static_cast<Subscriptable *>(range.as<Range>().get()));
+    ASSERT_EQ(dictionary.as<Enumerable>(),
+              static_cast<Enumerable *>(dictionary.as<Dictionary>().get()));
+    ASSERT_FALSE(range.as<Copyable>());
+    ASSERT_FALSE(dictionary.as<NumberCastable>());
+}
+
+TEST_CASE(Value, CastsObjectsOfOtherKinds) {
+    Value object(MakeStrong<TrackingObject>());
+    ASSERT_TRUE(object.as<TrackingObject>());
+    ASSERT_FALSE(object.as<List>());
+    ASSERT_FALSE(object.as<Copyable>());
+}
+
+class DerivedList : public List {};
+
+TEST_CASE(Value, CastsToSubclassesOfRuntimeClasses) {
+    Value list(MakeStrong<List>());
+    Value derived(MakeStrong<DerivedList>());
+    ASSERT_FALSE(list.as<DerivedList>());
+    ASSERT_TRUE(derived.as<DerivedList>());
+    ASSERT_TRUE(derived.as<List>());
+    ASSERT_TRUE(derived.as<Copyable>());
+}
+
+TEST_CASE(Value, ListsStoreNumbersUnboxed) {
+    std::vector<Value> values;
+    for (Integer i = 1; i <= 8; i++) {
+        values.push_back(Value(i));
+    }
+    auto integers = MakeStrong<List>(values);
+    ASSERT_EQ(integers->storage(), List::Storage::Integers);
+    ASSERT_EQ(integers->reservedBytes(), 8 * sizeof(Integer));
+    ASSERT_EQ(integers->at(2).asInteger(), 3);
+
+    auto floats = MakeStrong<List>(std::vector<Value>{Value(1.5), Value(2.5)});
+    ASSERT_EQ(floats->storage(), List::Storage::Floats);
+    ASSERT_TRUE(floats->contains(Value(1.5)));
+
+    auto mixed = MakeStrong<List>(std::vector<Value>{Value(1), Value(2.5)});
+    ASSERT_EQ(mixed->storage(), List::Storage::Values);
+    ASSERT_TRUE(mixed->at(0).isInteger());
+}
+
+TEST_CASE(Value, ShortListsStoreElementsInline) {
+    auto pair = MakeStrong<List>(std::vector<Value>{Value(std::string("x")), Value(2.5)});
+    ASSERT_EQ(pair->storage(), List::Storage::Values);
+    ASSERT_EQ(pair->reservedBytes(), 0u);
+
+    pair->append(Value(3));
+    ASSERT_NEQ(pair->reservedBytes(), 0u);
+    pair->erase(0, 1);
+    pair->insert(0, *pair);
+    ASSERT_EQ(pair->size(), 4u);
+    ASSERT_EQ(pair->at(0).asFloat(), 2.5);
+    ASSERT_EQ(pair->at(3).asInteger(), 3);
+
+    auto copy = MakeStrong<List>(pair->elements());
+    ASSERT_TRUE(copy->equals(pair));
+
+    // Room left in front of inline elements is reclaimed in place.
+    auto inlined = MakeStrong<List>(std::vector<Value>{Value(std::string("x")), Value(2.5)});
+    for (Integer i = 0; i < 10; i++) {
+        inlined->erase(0, 1);
+        inlined->append(Value(i));
+        ASSERT_EQ(inlined->reservedBytes(), 0u);
+    }
+    ASSERT_EQ(inlined->description(), "[8, 9]");
+}
+
+TEST_CASE(Value, ListsWorkAsQueues) {
+    auto list = MakeStrong<List>();
+    for (Integer i = 0; i < 100; i++) {
+        list->insert(0, Value(i));
+    }
+    ASSERT_EQ(list->size(), 100u);
+    ASSERT_EQ(list->at(0).asInteger(), 99);
+    ASSERT_EQ(list->at(99).asInteger(), 0);
+
+    // Erasing from the front leaves room that later appends reclaim, rather than growing.
+    for (Integer i = 100; i < 10000; i++) {
+        list->append(Value(i));
+        list->erase(0, 1);
+    }
+    ASSERT_EQ(list->size(), 100u);
+    ASSERT_EQ(list->at(0).asInteger(), 9900);
+    ASSERT_LTE(list->reservedBytes(), 4 * 100 * sizeof(Integer));
+
+    auto names = MakeStrong<List>(std::vector<Value>{Value(std::string("b"))});
+    names->insert(0, Value(std::string("a")));
+    names->insert(0, *MakeStrong<List>(std::vector<Value>(4, Value(1.5))));
+    names->erase(0, 2);
+    ASSERT_EQ(names->description(), "[1.5, 1.5, \"a\", \"b\"]");
+}
+
+TEST_CASE(Value, ListsWidenToValues) {
+    auto list = MakeStrong<List>();
+    list->append(Value(1));
+    list->append(Value(2));
+    ASSERT_EQ(list->storage(), List::Storage::Integers);
+
+    list->append(Value(std::string("three")));
+    ASSERT_EQ(list->storage(), List::Storage::Values);
+    ASSERT_EQ(list->size(), 3u);
+    ASSERT_EQ(list->at(1).asInteger(), 2);
+    ASSERT_EQ(list->at(2).toString(), "three");
+
+    list->erase(0, list->size());
+    list->append(Value(0.5));
+    ASSERT_EQ(list->storage(), List::Storage::Floats);
+}
+
+TEST_CASE(Value, ValueMapsKeepInsertionOrder) {
+    ValueMap map;
+    for (Integer i = 0; i < 100; i++) {
+        map[Value(i * 7)] = Value(i);
+    }
+    for (Integer i = 0; i < 100; i += 2) {
+        ASSERT_EQ(map.erase(Value(i * 7)), 1u);
+    }
+    ASSERT_EQ(map.erase(Value(0)), 0u);
+    ASSERT_EQ(map.size(), 50u);
+    ASSERT_TRUE(map.contains(Value(7.0)));
+    ASSERT_FALSE(map.contains(Value(14)));
+
+    map[Value(14)] = Value(-1);
+    for (Integer i = 100; i < 200; i++) {
+        map[Value(i * 7)] = Value(i);
+    }
+    ASSERT_EQ(map.size(), 151u);
+
+    Integer expected = 1;
+    auto it = map.begin();
+    for (; expected < 100; expected += 2, it++) {
+        ASSERT_EQ(it->second.asInteger(), expected);
+    }
+    ASSERT_EQ(it->second.asInteger(), -1);
+    for (expected = 100, it++; expected < 200; expected++, it++) {
+        ASSERT_EQ(it->second.asInteger(), expected);
+    }
+    ASSERT_TRUE(it == map.end());
+}
+
+TEST_CASE(Value, HashesEqualNumbersAlike) {
+    Value::Hash hash;
+    ASSERT_EQ(hash(Value(3)), hash(Value(3.0)));
+    ASSERT_EQ(hash(Value(-7)), hash(Value(-7.0)));
+    ASSERT_EQ(hash(Value(Integer(1) << 60)), hash(Value(static_cast<Float>(Integer(1) << 60))));
+    ASSERT_NEQ(hash(Value(3)), hash(Value(3.5)));
+
+    auto integers = MakeStrong<List>(std::vector<Value>{Value(1), Value(2)});
+    auto values = MakeStrong<List>(std::vector<Value>{Value(1), Value(2.0)});
+    ASSERT_EQ(hash(Value(integers)), hash(Value(values)));
+}
+
+TEST_CASE(Value, ListHashesDependOnOrder) {
+    Value::Hash hash;
+    auto list = [](Integer x, Integer y) {
+        return Value(MakeStrong<List>(std::vector<Value>{Value(x), Value(y)}));
+    };
+    ASSERT_NEQ(hash(list(1, 2)), hash(list(2, 1)));
+    ASSERT_NEQ(hash(list(1, 1)), hash(list(2, 2)));
+}
+
+TEST_CASE(Value, ForgetsCachedHashesOnMutation) {
+    Value::Hash hash;
+    auto list = MakeStrong<List>(std::vector<Value>{Value(1), Value(2)});
+    auto before = hash(Value(list));
+    list->append(Value(3));
+    ASSERT_NEQ(hash(Value(list)), before);
+    ASSERT_EQ(hash(Value(list)),
+              hash(Value(MakeStrong<List>(std::vector<Value>{Value(1), Value(2), Value(3)}))));
+
+    auto string = MakeStrong<String>("ab");
+    before = hash(Value(string));
+    string->string().append("c");
+    ASSERT_NEQ(hash(Value(string)), before);
+    ASSERT_EQ(hash(Value(string)), hash(Value(MakeStrong<String>("abc"))));
+
+    auto dictionary = MakeStrong<Dictionary>();
+    before = hash(Value(dictionary));
+    dictionary->values()[Value(1)] = Value(2);
+    ASSERT_NEQ(hash(Value(dictionary)), before);
+}
+
+TEST_CASE(Value, CopiesShareElementsUntilChanged) {
+    VirtualMachine vm;
+    auto list = vm.make<List>(std::vector<Value>(8, Value(std::string("a"))));
+    Value copy = list->copy(vm);
+    auto copiedList = copy.as<List>();
+    ASSERT_TRUE(list->isShared());
+    ASSERT_TRUE(copiedList->equals(list));
+
+    copiedList->set(0, Value(1));
+    ASSERT_FALSE(list->isShared());
+    ASSERT_FALSE(copiedList->isShared());
+    ASSERT_EQ(list->at(0), Value(std::string("a")));
+    ASSERT_EQ(copiedList->at(0).asInteger(), 1);
+
+    // Natives that only read a list leave its elements shared.
+    copy = list->copy(vm);
+    auto asSet = Core().values()["{} as (a/an) set"].as<Native>();
+    Value arguments[] = {Value(list)};
+    auto set = asSet->callable()(NativeCallContext(vm, SourceLocation(), arguments));
+    ASSERT_TRUE(set.has_value());
+    ASSERT_EQ(set.value().as<HashSet>()->size(), 1u);
+    ASSERT_TRUE(list->isShared());
+
+    auto pair = vm.make<List>(std::vector<Value>{Value(1), Value(2)});
+    Value pairCopy = pair->copy(vm);
+    ASSERT_FALSE(pair->isShared());
+    ASSERT_TRUE(pairCopy.as<List>()->equals(pair));
+
+    auto dictionary = vm.make<Dictionary>();
+    dictionary->values()[Value(1)] = Value(2);
+    copy = dictionary->copy(vm);
+    auto copiedDictionary = copy.as<Dictionary>();
+    ASSERT_TRUE(dictionary->isShared());
+    ASSERT_TRUE(copiedDictionary->equals(dictionary));
+
+    dictionary->values()[Value(3)] = Value(4);
+    ASSERT_FALSE(copiedDictionary->isShared());
+    ASSERT_EQ(dictionary->values().size(), 2u);
+    ASSERT_EQ(copiedDictionary->values().size(), 1u);
+}
@@ -0,0 +1,269 @@
+//
+//  Copyright (c) 2025 James Callender
+//
+//  Licensed under the Apache License, Version 2.0 (the "License");
+//  you may not use this file except in compliance with the License.
+//  You may obtain a copy of the License at
+//
+//  http://www.apache.org/licenses/LICENSE-2.0
+//
+//  Unless required by applicable law or agreed to in writing, software
+//  distributed under the License is distributed on an "AS IS" BASIS,
+//  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//  See the License for the specific language governing permissions and
+//  limitations under the License.
+//
+
+#include "tests/AllocationCounter.h"
+#include "tests/TestSuite.h"
+
+#include <sif/compiler/Compiler.h>
+#include <sif/compiler/Parser.h>
+#include <sif/compiler/Reader.h>
+#include <sif/compiler/Reporter.h>
+#include <sif/compiler/Scanner.h>
+#include <sif/compiler/Signature.h>
+#include <sif/runtime/ModuleLoader.h>
+#include <sif/runtime/VirtualMachine.h>
+#include <sif/runtime/objects/List.h>
+#include <sif/runtime/objects/Native.h>
+
+#include <sstream>
+#include <thread>
+
+using namespace sif;
+
+static Strong<Bytecode> Compile(const std::string &source,
+                                const std::vector<std::string> &signatures,
+                                bool registerInstructions = false) {
+    std::ostringstream err;
+    Scanner scanner;
+    StringReader reader(source);
+    ModuleLoader loader;
+    IOReporter reporter(err);
+    ParserConfig parserConfig{scanner, reader, loader, reporter};
+    Parser parser(parserConfig);
+    for (const auto &signature : signatures) {
+        parser.declare(Signature::Make(signature).value());
+    }
+    auto statement = parser.statement();
+    if (parser.failed()) {
+        return nullptr;
+    }
+    CompilerConfig config{loader, reporter, false, true};
+    config.registerInstructions = registerInstructions;
+    Compiler compiler(config);
+    return compiler.compile(*statement);
+}
+
+static Strong<Native> Constant(Integer value) {
+    return MakeStrong<Native>(
+        [value](const NativeCallContext &) -> Result<Value, Error> { return Value(value); });
+}
+
+TEST_CASE(VirtualMachine, ResolvesGlobalsAddedAfterFirstReference) {
+    auto bytecode = Compile("answer", {"answer"});
+    ASSERT_TRUE(bytecode);
+
+    VirtualMachine vm;
+    auto unbound = vm.execute(bytecode);
+    ASSERT_FALSE(unbound.has_value());
+
+    vm.addGlobal("answer", Constant(42));
+    auto bound = vm.execute(bytecode);
+    ASSERT_TRUE(bound.has_value());
+    ASSERT_EQ(bound.value().asInteger(), 42);
+}
+
+TEST_CASE(VirtualMachine, RelinksBytecodeSharedBetweenMachines) {
+    auto bytecode = Compile("answer", {"answer"});
+    ASSERT_TRUE(bytecode);
+
+    VirtualMachine first;
+    first.addGlobal("unrelated", Constant(0));
+    first.addGlobal("answer", Constant(1));
+
+    VirtualMachine second;
+    second.addGlobal("answer", Constant(2));
+
+    ASSERT_EQ(first.execute(bytecode).value().asInteger(), 1);
+    ASSERT_EQ(second.execute(bytecode).value().asInteger(), 2);
+    ASSERT_EQ(first.execute(bytecode).value().asInteger(), 1);
+}
+
+TEST_CASE(VirtualMachine, CopiesContainerConstantsWithoutChangingThem) {
+    auto constant = MakeStrong<List>(std::vector<Value>(8, Value(std::string("a"))));
+    auto bytecode = MakeStrong<Bytecode>();
+    bytecode->add(SourceLocation(), Opcode::Constant, bytecode->addConstant(constant));
+    bytecode->add(SourceLocation(), Opcode::Return);
+
+    for (int i = 0; i < 2; i++) {
+        VirtualMachine vm;
+        auto result = vm.execute(bytecode);
+        ASSERT_TRUE(result.has_value());
+        ASSERT_TRUE(result.value().as<List>()->equals(constant));
+        ASSERT_FALSE(constant->isShared());
+    }
+    ASSERT_EQ(constant->size(), 8u);
+}
+
+TEST_CASE(VirtualMachine, ExportsShadowGlobals) {
+    auto bytecode = Compile("set global value to 1\nvalue", {});
+    ASSERT_TRUE(bytecode);
+
+    VirtualMachine vm;
+    vm.addGlobal("value", Value(0));
+    auto result = vm.execute(bytecode);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result.value().asInteger(), 1);
+
+    auto exports = vm.exports();
+    ASSERT_EQ(exports.size(), 1u);
+    ASSERT_EQ(exports["value"].asInteger(), 1);
+    ASSERT_EQ(vm.globals()["value"].asInteger(), 0);
+}
+
+TEST_CASE(VirtualMachine, NativeCallsDoNotAllocate) {
+    ASSERT_EQ(AllocationGrowth(suite, "set i to 0\n"
+                                      "repeat while i < iterations\n"
+                                      "  touch i\n"
+                                      "  set i to i + 1\n"
+                                      "end repeat"),
+              0u);
+}
+
+TEST_CASE(VirtualMachine, CountedLoopsDoNotAllocate) {
+    ASSERT_EQ(AllocationGrowth(suite, "repeat for i in 0 ..< iterations\n"
+                                      "  i\n"
+                                      "end repeat"),
+              0u);
+}
+
+TEST_CASE(VirtualMachine, RegisterInstructionsAddressLocals) {
+    auto source = "set x to 3\n"
+                  "set y to x * 2\n"
+                  "set y to y + (x - 1)\n"
+                  "y";
+    auto stack = Compile(source, {});
+    auto registers = Compile(source, {}, true);
+    ASSERT_TRUE(stack);
+    ASSERT_TRUE(registers);
+
+    auto count = [](const Bytecode &bytecode, Opcode opcode) {
+        int count = 0;
+        const auto &code = bytecode.code();
+        for (size_t i = 0; i < code.size(); i += InstructionLength(code[i])) {
+            count += code[i] == opcode;
+        }
+        return count;
+    };
+    ASSERT_EQ(count(*registers, Opcode::SetLocal), 0);
+    ASSERT_EQ(count(*registers, Opcode::RegisterAdd), 1);
+    ASSERT_LT(registers->code().size(), stack->code().size());
+
+    VirtualMachine vm;
+    ASSERT_EQ(vm.execute(stack).value().asInteger(), 8);
+    ASSERT_EQ(vm.execute(registers).value().asInteger(), 8);
+}
+
+TEST_CASE(VirtualMachine, StringLiteralsAreNotCopiedUntilStored) {
+    ASSERT_EQ(AllocationGrowth(suite, "repeat for i in 0 ..< iterations\n"
+                                      "  touch \"literal\"\n"
+                                      "end repeat"),
+              0u);
+}
+
+TEST_CASE(VirtualMachine, OwnsNullObjectReferences) {
+    VirtualMachine vm;
+    Value null(Strong<Object>{});
+    ASSERT_FALSE(null.isLiteral());
+    ASSERT_TRUE(vm.own(null).isObject());
+}
+
+TEST_CASE(VirtualMachine, UnpacksPairsWithoutLists) {
+    auto bytecode = Compile("function pair of {n}\n"
+                            "  return [n, n + 1]\n"
+                            "end function\n"
+                            "set total to 0\n"
+                            "repeat for i in 0 ..< 1000\n"
+                            "  set a, b to pair of i\n"
+                            "  set total to total + a + b\n"
+                            "end repeat\n"
+                            "set squares to [1: 1, 2: 4, 3: 9]\n"
+                            "repeat for i in 0 ..< 1000\n"
+                            "  repeat for key, value in squares\n"
+                            "    set total to total + value - key\n"
+                            "  end repeat\n"
+                            "end repeat\n"
+                            "total",
+                            {});
+    ASSERT_TRUE(bytecode);
+
+    VirtualMachine vm;
+    auto result = vm.execute(bytecode);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(result.value().asInteger(), 1000000 + 8000);
+    ASSERT_LT(vm.heapStatistics().allocations, 1100u);
+}
+
+TEST_CASE(VirtualMachine, ReusesHeapCells) {
+    auto bytecode = Compile("repeat for i in 0 ..< 1000\n"
+                            "  set pair to [i, i + 1]\n"
+                            "end repeat\n"
+                            "[1, 2]",
+                            {});
+    ASSERT_TRUE(bytecode);
+
+    Value survivor;
+    {
+        VirtualMachine vm;
+        auto result = vm.execute(bytecode);
+        ASSERT_TRUE(result.has_value());
+        survivor = result.value();
+
+        const auto &statistics = vm.heapStatistics();
+        ASSERT_GTE(statistics.allocations, 1000u);
+        ASSERT_EQ(statistics.allocations - statistics.deallocations, statistics.liveObjects);
+        ASSERT_LT(statistics.liveObjects, 10u);
+        ASSERT_LT(statistics.slabs, 8u);
+    }
+    auto list = survivor.as<List>();
+    ASSERT_TRUE(list);
+    ASSERT_EQ(list->values().size(), 2u);
+    ASSERT_EQ(list->values()[1].asInteger(), 2);
+}
+
+class LargeObject : public Object {
+  public:
+    std::string typeName() const override { return "large object"; }
+    std::string description() const override { return "large object"; }
+
+    char bytes[4096];
+};
+
+TEST_CASE(VirtualMachine, AllocatesLargeObjectsWithoutSlabs) {
+    VirtualMachine vm;
+    auto before = vm.heapStatistics().reservedBytes;
+    auto object = vm.make<LargeObject>();
+    ASSERT_EQ(vm.heapStatistics().slabs, 0u);
+    ASSERT_LT(vm.heapStatistics().reservedBytes - before, sizeof(LargeObject) + 64);
+    object.reset();
+    ASSERT_EQ(vm.heapStatistics().reservedBytes, before);
+    ASSERT_EQ(vm.heapStatistics().liveObjects, 0u);
+}
+
+// Destroyed after the thread's heap is given up, since it is constructed before the heap is.
+struct AllocatesOnThreadExit {
+    ~AllocatesOnThreadExit() {
+        auto list = MakeStrong<List>(std::vector<Value>{Value(1)});
+        list->append(Value(MakeStrong<LargeObject>()));
+    }
+};
+
+TEST_CASE(VirtualMachine, AllocatesAfterTheThreadHeapIsGivenUp) {
+    std::thread([] {
+        static thread_local AllocatesOnThreadExit allocator;
+        (void)&allocator;
+        MakeStrong<List>();
+    }).join();
+}
@@ -30,6 +30,7 @@
 #include <sif/runtime/objects/String.h>
 
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <random>
@@ -66,8 +67,10 @@ static bool prettyPrint = false;
 static bool printBytecode = false;
 static bool printBytecodeClean = false;
 static bool noDebugInfo = false;
+static bool registerInstructions = false;
 static const char *codeString = nullptr;
 static bool interactive = false;
+static int garbageCollectionStatistics = 0;
 
 ModuleLoader loader;
 VirtualMachine vm;
@@ -137,6 +140,7 @@ int evaluate(const std::string &name, Reader &reader) {
     }
 
     CompilerConfig compilerConfig{loader, reporter, interactive, !noDebugInfo};
+    compilerConfig.registerInstructions = registerInstructions;
     Compiler compiler(compilerConfig);
     auto bytecode = compiler.compile(*statement);
     if (!bytecode) {
@@ -166,7 +170,8 @@ int evaluate(const std::string &name, Reader &reader) {
 
     variables = parser.variables();
     signatures = parser.signatures();
-    globals.insert(vm.exports().begin(), vm.exports().end());
+    auto exports = vm.exports();
+    globals.insert(exports.begin(), exports.end());
 
     return Success;
 }
@@ -202,6 +207,47 @@ static int run_file(const std::string &fileName, const std::vector<std::string>
     return evaluate(fileName, reader);
 }
 
+void print_gc_stats() {
+    using namespace std::chrono;
+    const auto &statistics = vm.garbageCollectionStatistics();
+    const auto &heap = vm.heapStatistics();
+    auto milliseconds = [](nanoseconds pause) {
+        return duration_cast<duration<double, std::milli>>(pause).count();
+    };
+
+    std::cerr << "Garbage collection:" << std::endl
+              << "  collections:      " << statistics.collections() << " ("
+              << statistics.youngCollections << " young, " << statistics.fullCollections
+              << " full)" << std::endl
+              << "  total pause:      " << milliseconds(statistics.totalPause) << "ms" << std::endl
+              << "  maximum pause:    " << milliseconds(statistics.maximumPause) << "ms"
+              << std::endl
+              << "  objects marked:   " << statistics.objectsMarked << std::endl
+              << "  objects freed:    " << statistics.objectsFreed << std::endl
+              << "  bytes reclaimed:  " << statistics.bytesReclaimed << std::endl
+              << "  live containers:  " << vm.liveContainerCount() << std::endl
+              << "  tracked bytes:    " << vm.currentTrackedBytes() << " (peak "
+              << statistics.peakTrackedBytes << ")" << std::endl
+              << "  heap bytes:       " << heap.reservedBytes << " (peak " << heap.peakReservedBytes
+              << ")" << std::endl;
+    if (statistics.collections() == 0) {
+        return;
+    }
+    std::cerr << "  pauses:" << std::endl;
+    for (size_t bucket = 0; bucket < statistics.pauseHistogram.size(); bucket++) {
+        auto count = statistics.pauseHistogram[bucket];
+        if (count == 0) {
+            continue;
+        }
+        if (bucket + 1 < statistics.pauseHistogram.size()) {
+            std::cerr << "    < " << (1ull << bucket) << "us: ";
+        } else {
+            std::cerr << "    >= " << (1ull << (bucket - 1)) << "us: ";
+        }
+        std::cerr << count << std::endl;
+    }
+}
+
 int usage(int argc, char *argv[]) {
     std::cout << "Usage: " << basename(argv[0]) << " [options...] [file]" << std::endl
 #if defined(DEBUG)
@@ -223,6 +269,10 @@ int usage(int argc, char *argv[]) {
               << "\t Print generated bytecode without source locations." << std::endl
               << " -n, --no-debug-info" << std::endl
               << "\t Include argument debug information for enhanced error reporting." << std::endl
+              << " -r, --register-instructions" << std::endl
+              << "\t Compile local arithmetic to register instructions." << std::endl
+              << "     --gc-stats" << std::endl
+              << "\t Print garbage collection statistics at exit." << std::endl
               << " -h, --help" << std::endl
               << "\t Print out this help menu." << std::endl;
     return -1;
@@ -242,12 +292,14 @@ int main(int argc, char *argv[]) {
         {"print-bytecode", no_argument, NULL, 'b'},
         {"print-bytecode-clean", no_argument, NULL, 'B'},
         {"no-debug-info", no_argument, NULL, 'n'},
+        {"register-instructions", no_argument, NULL, 'r'},
+        {"gc-stats", no_argument, &garbageCollectionStatistics, 1},
         {"help", no_argument, NULL, 'h'},
         {0, 0, 0, 0}
     };
 
     int c, opt_index = 0;
-    while ((c = getopt_long(argc, argv, "pBbnhie:", long_options, &opt_index)) != -1) {
+    while ((c = getopt_long(argc, argv, "pBbnrhie:", long_options, &opt_index)) != -1) {
         switch (c) {
         case 'p':
             prettyPrint = true;
@@ -261,6 +313,10 @@ int main(int argc, char *argv[]) {
         case 'n':
             noDebugInfo = true;
             break;
+        case 'r':
+            registerInstructions = true;
+            loader.config.registerInstructions = true;
+            break;
         case 'e':
             codeString = optarg;
             break;
@@ -302,6 +358,9 @@ int main(int argc, char *argv[]) {
     vmConfig.enableTracing = traceRuntime;
 #endif
     vm.config = vmConfig;
+    if (garbageCollectionStatistics) {
+        std::atexit(print_gc_stats);
+    }
 
     for (const auto &pair : coreModule.values()) {
         vm.addGlobal(pair.first, pair.second);
@@ -24,8 +24,9 @@ SIF_NAMESPACE_BEGIN
 
 class hasher {
   public:
+    // Order matters, so that permutations of the same values hash differently.
     template <typename T, typename Hasher> void hash(const T &value, const Hasher &hasher) {
-        _value = _value ^ (hasher(value) << 1);
+        _value ^= hasher(value) + 0x9e3779b97f4a7c15ULL + (_value << 6) + (_value >> 2);
     }
 
     template <typename T> void combine(const T &value) { hash(value, std::hash<T>{}); }